@@ -1,11 +1,46 @@
 import gcam_module
-from os import chdir
+from os import chdir, makedirs
+from os.path import join
 from pandas import DataFrame, Series
-from gcamwrapper.query_library import apply_query_params
+from gcamwrapper.query_library import apply_query_params, find_placeholders, get_query
 import numpy as np
 import warnings
 
 
+def _data_frame_to_dict(data_df):
+    """Transform a DataFrame to the dict of column name to numpy array which is
+       expected when passing data to GCAM.
+    """
+
+    data_dict = dict()
+    last_key = data_df.columns[-1] if len(data_df.columns) > 0 else None
+    for key, value in data_df.items():
+        data_as_numpy = value.to_numpy()
+        if (key == last_key or str(key).isdigit()) and np.issubdtype(data_as_numpy.dtype, np.number):
+            # the values to set, which for wide data are the year columns,
+            # are always read as real numbers
+            data_as_numpy = data_as_numpy.astype(np.float64)
+        elif data_as_numpy.dtype == np.int64:
+            data_as_numpy = data_as_numpy.astype(np.int32)
+            if key != "year" and key != "period":
+                warnings.warn(f"Implict conversion to int32 for {key} may result in loss of data")
+        # wide year columns may be labeled by int
+        data_dict[str(key)] = data_as_numpy
+    return data_dict
+
+
+def _aggregate_data(data_dict):
+    """Aggregate the unaggregated query results comming out of GCAM.
+    """
+
+    data_df = DataFrame(data_dict)
+    # first figure out what the "value" column is, group by everything else, and summarize
+    # TODO: decide on failure mode when no results
+    cols = data_df.columns
+    value_col = cols[-2] if cols[-1] == "year" else cols[-1]
+    return data_df.groupby(cols.drop(value_col).to_list(), as_index=False).sum()
+
+
 class Gcam(gcam_module.gcam):
     """A wrapper around GCAM to interactively run a scenario and use
        GCAMFusion capabilities to get/set arbitrary data from a running
@@ -28,10 +63,10 @@ class Gcam(gcam_module.gcam):
     def run_period(self, period=None, post_init_calback=None):
         """ Run GCAM up to and including some model period.
             Model periods which have already been run will be kept track
-            of and will not be run again.  HOWEVER, we do not attempt to
-            keep track of if those model periods are "dirty" such as if
-            a user has called `set_data` in such a way that would invalidate
-            that solution.
+            of and will not be run again.  HOWEVER, model periods which have
+            been made "dirty", such as if a user has called `set_data` in such
+            a way that would invalidate that solution, will not be re-run
+            automatically.  Users should call `rerun_from_earliest_dirty` to do so.
 
         :param period: The model period to run or the `get_current_period` + 1
                        if None
@@ -53,8 +88,113 @@ class Gcam(gcam_module.gcam):
            post_init_calback(self)
            super(Gcam, self).run_period_post(period, True)
 
-    def get_data(self, query, *args, **kwargs):
-        """Queries for arbitrary data from a running instance of GCAM.
+    def set_defer_climate(self, defer=True):
+        """Set if the climate model should be run each period or only on demand
+           When deferred, running model periods skips the climate model until
+           `run_climate_model` is called, which is useful when the climate results
+           are only needed at the end.  Any climate results queried in the
+           meantime will be out of date.  If there are any model feedbacks, which
+           may depend on the climate model, or the configuration uses a scenario
+           runner other than the single scenario runner, such as for a policy
+           target, it will continue to run each period.  Turning deferral off
+           first runs the climate model for any periods which were skipped.
+
+        :param defer: If the climate model should be deferred
+        :type defer:  bool
+        """
+
+        super(Gcam, self).set_defer_climate(defer)
+
+    def run_climate_model(self):
+        """Run the climate model for all model periods which have been run
+           without it while it was deferred, see `set_defer_climate`.
+        """
+
+        super(Gcam, self).run_climate_model()
+
+    def load_plugin(self, path, options=""):
+        """Load a shared library which implements the gcamwrapper plugin
+           interface described in `gcamwrapper_plugin.h`.  The plugin is called
+           as each model period is run, once the period has been initialized and
+           again once it has been solved, at the same points as the
+           `post_init_calback` of `run_period` but without the overhead of calling
+           back into Python.  Plugins are called in the order they were loaded.
+           Plugins are only available when the configuration uses the single
+           scenario runner.
+
+        :param path: The path to the shared library
+        :type path:  str
+        :param options: An arbitrary string passed along to the plugin when it is
+                        created
+        :type options:  str
+        """
+
+        super(Gcam, self).load_plugin(path, options)
+
+    def clear_plugins(self):
+        """Unload all native plugins.
+        """
+
+        super(Gcam, self).clear_plugins()
+
+    def get_plugins(self):
+        """Get the names of the loaded native plugins.
+
+        :returns: The names of the plugins in the order they were loaded
+        """
+
+        return super(Gcam, self).get_plugins()
+
+    def set_checkpoint_file(self, file):
+        """Write a checkpoint of the solved prices to `file` each time a model
+           period is run so that if a long run fails it can be resumed from the
+           last completed period with `resume_from_checkpoint`.  The checkpoint is
+           written in the background to a temporary file which then replaces
+           `file`, so `file` always holds the last complete checkpoint.
+
+        :param file: The checkpoint file to write or an empty string to stop
+                     checkpointing
+        :type file:  str
+        """
+
+        super(Gcam, self).set_checkpoint_file(file)
+
+    def resume_from_checkpoint(self, file):
+        """Run all of the model periods in a checkpoint written by
+           `set_checkpoint_file` again, starting the solver in each period from
+           the checkpointed prices.  As the solver starts at the solution this is
+           much faster than solving the periods from scratch.  Note the model must
+           have been set up with the same inputs as when the checkpoint was
+           written for the results to match.
+
+        :param file: The checkpoint file to resume from
+        :type file:  str
+        """
+
+        super(Gcam, self).resume_from_checkpoint(file)
+
+    def get_earliest_dirty_period(self):
+        """Get the earliest model period which has already been run but has
+           since had data changed by `set_data` or `set_data_fast`.
+
+        :returns: The earliest dirty model period or -1 if no periods are dirty
+        """
+
+        return super(Gcam, self).get_earliest_dirty_period()
+
+    def rerun_from_earliest_dirty(self):
+        """Re-run the model from the earliest dirty model period up to and
+           including the current model period.  Periods before the earliest
+           dirty period are kept as is.  If no periods are dirty nothing is run.
+        """
+
+        super(Gcam, self).rerun_from_earliest_dirty()
+
+    def get_data(self, query, *args, value_filter=None, wide=False, **kwargs):
+        """Queries for arbitrary data from a running instance of GCAM.  The
+           results of recent queries are kept so that running the same query
+           again before the model has changed, by running a period or setting
+           data for instance, does not need to search the model again.
 
         :param query:   GCAM fusion query
         :type query:    str
@@ -64,8 +204,18 @@ class Gcam(gcam_module.gcam):
         :param **kargs: User options to translate placeholder expressions which will
                         get combined with *args and passed on to apply_query_params
         :type **kargs:  key = arrary(str)
-
-        :returns:       DataFrame with the query results.
+        :param value_filter: If not None drop values before they are recorded
+                             unless they pass all of the `,` separated conditions
+                             which may be `nonzero`, `finite`, or a comparison
+                             such as `> 1e-6` (with `>`, `>=`, `<`, `<=`, `==`, `!=`)
+        :type value_filter:  str
+        :param wide:    If True, each vector of data by year becomes a single row
+                        with a column for each year, named by the year, rather
+                        than having a year column.  Years not found are NaN.
+        :type wide:     bool
+
+        :returns:       DataFrame with the query results.  Note the value_filter
+                        is applied before the results are aggregated.
 
         """
 
@@ -77,14 +227,20 @@ class Gcam(gcam_module.gcam):
         # replace any potential place holders in the query with the query params
         query = apply_query_params(query, kwargs, True)
 
-        data_dict = super(Gcam, self).get_data(query)
-        data_df = DataFrame(data_dict)
-        # The data comming out of gcam is unaggregated so we will need to do that now
-        # first figure out what the "value" column is, group by everything else, and summarize
-        # TODO: decide on failure mode when no results
-        cols = data_df.columns
-        value_col = cols[-2] if cols[-1] == "year" else cols[-1]
-        data_df = data_df.groupby(cols.drop(value_col).to_list(), as_index=False).sum()
+        if wide:
+            data_df = DataFrame(super(Gcam, self).get_data_wide(query, value_filter or ""))
+            # The data comming out of gcam is unaggregated so we will need to do that now
+            # the year columns are the value columns and we group by everything else
+            year_cols = [col for col in data_df.columns if col.isdigit()]
+            path_cols = [col for col in data_df.columns if not col.isdigit()]
+            if len(path_cols) > 0:
+                data_df = data_df.groupby(path_cols, as_index=False)[year_cols].sum(min_count=1)
+            else:
+                data_df = data_df.sum(min_count=1).to_frame().T
+        else:
+            data_dict = super(Gcam, self).get_data(query, value_filter or "")
+            # The data comming out of gcam is unaggregated so we will need to do that now
+            data_df = _aggregate_data(data_dict)
         if units is not None:
             # Attempting to attach meta data to the data frame will generate a warning:
             # Pandas doesn't allow columns to be created via a new attribute name
@@ -95,6 +251,267 @@ class Gcam(gcam_module.gcam):
                 data_df.meta = {'units': units}
         return data_df
 
+    def profile_get_data(self, query, *args, value_filter=None, **kwargs):
+        """Runs the query as `get_data` would but reports where the time was
+           spent rather than the results, which helps to find out why a query
+           is slow and how to make it more selective.  Each filter step which
+           has a predicate reports how many times it was evaluated, which is the
+           number of nodes the step visited, how many of those matched, and the
+           time spent evaluating it.  Steps without a predicate visit every node
+           and report NaN.  Results are never taken from the query cache so the
+           full cost is reported.
+
+        :param query:   GCAM fusion query
+        :type query:    str
+        :param *args: User options to translate placeholder expressions which will
+                      will be added to the kwargs as dict(arg: None)
+        :type *args:  str
+        :param **kargs: User options to translate placeholder expressions which will
+                        get combined with *args and passed on to apply_query_params
+        :type **kargs:  key = arrary(str)
+        :param value_filter: If not None drop values before they are recorded,
+                             see `get_data`
+        :type value_filter:  str
+
+        :returns:       A dict with `steps` a DataFrame with the columns step,
+                        filter, evaluated, matched, and time (in seconds) and
+                        `summary` a DataFrame with the columns setup_time,
+                        traversal_time, conversion_time, and leaves which is the
+                        number of values recorded.
+
+        """
+
+        # fold args into kwargs by using the value as the key and the implict value is None
+        for arg in args:
+            kwargs[arg] = None
+
+        # replace any potential place holders in the query with the query params
+        query = apply_query_params(query, kwargs, True)
+
+        steps, summary = super(Gcam, self).profile_get_data(query, value_filter or "")
+        return {"steps": DataFrame(steps), "summary": DataFrame(summary)}
+
+    def dry_run(self, query, *args, value_filter=None, **kwargs):
+        """Parses and runs the query as `get_data` would but only counts the
+           values found without recording them, so it is a cheap way to guard
+           against a query which would find far more data than intended.  The
+           count is taken before the results are aggregated so it is an upper
+           bound on the rows `get_data` returns.  An invalid query is an error
+           and if nothing is found a warning points to the first step of the
+           query which did not find anything, which is likely a mistyped data
+           name.
+
+        :param query:   GCAM fusion query
+        :type query:    str
+        :param *args: User options to translate placeholder expressions which will
+                      will be added to the kwargs as dict(arg: None)
+        :type *args:  str
+        :param **kargs: User options to translate placeholder expressions which will
+                        get combined with *args and passed on to apply_query_params
+        :type **kargs:  key = arrary(str)
+        :param value_filter: If not None only count values which pass the
+                             filter, see `get_data`
+        :type value_filter:  str
+
+        :returns:       The number of values the query found.
+
+        """
+
+        # fold args into kwargs by using the value as the key and the implict value is None
+        for arg in args:
+            kwargs[arg] = None
+
+        # replace any potential place holders in the query with the query params
+        query = apply_query_params(query, kwargs, True)
+
+        return int(super(Gcam, self).dry_run(query, value_filter or ""))
+
+    def profile_set_data(self, data_df, query, *args, fast=False, **kwargs):
+        """Sets the data as `set_data` or `set_data_fast` would but also reports
+           where the time was spent, see `profile_get_data`.  Note the data
+           really is set.
+
+        :param data_df:     DataFrame of data to set
+        :type data_df:      DataFrame
+        :param query:       GCAM fusion query
+        :type query:        str
+        :param *args: User options to translate placeholder expressions which will
+                      will be added to the kwargs as dict(arg: None)
+        :type *args:  str
+        :param **kargs: User options to translate placeholder expressions which will
+                        get combined with *args and passed on to apply_query_params
+        :type **kargs:  key = arrary(str)
+        :param fast:        If True profile `set_data_fast` instead of `set_data`
+        :type fast:         bool
+
+        :returns:       A dict with `steps` and `summary` as for
+                        `profile_get_data` where setup_time includes reading the
+                        data, conversion_time is zero, and leaves is the number of
+                        values set.
+
+        """
+
+        # fold args into kwargs by using the value as the key and the implict value is None
+        for arg in args:
+            kwargs[arg] = None
+
+        # replace any potential place holders in the query with the query params
+        # note set_data_fast uses the query as a get_data call would
+        query = apply_query_params(query, kwargs, fast)
+
+        steps, summary = super(Gcam, self).profile_set_data(_data_frame_to_dict(data_df), query, fast)
+        return {"steps": DataFrame(steps), "summary": DataFrame(summary)}
+
+    def get_data_chunked(self, query, chunk_size, callback, *args, value_filter=None, **kwargs):
+        """Queries for arbitrary data from a running instance of GCAM handing
+           off the results in chunks as the query proceeds so that the memory
+           required stays bounded.
+           Note unlike `get_data` the results are NOT aggregated as rows which
+           would be aggregated together may end up in different chunks.
+
+        :param query:   GCAM fusion query
+        :type query:    str
+        :param chunk_size: The number of rows to include in each chunk
+        :type chunk_size:  int
+        :param callback: A function which will be called with a DataFrame of
+                         each chunk of results
+        :type callback:  function
+        :param *args: User options to translate placeholder expressions which will
+                      will be added to the kwargs as dict(arg: None)
+        :type *args:  str
+        :param **kargs: User options to translate placeholder expressions which will
+                        get combined with *args and passed on to apply_query_params
+        :type **kargs:  key = arrary(str)
+        :param value_filter: If not None drop values before they are recorded
+                             unless they pass all of the `,` separated conditions
+                             which may be `nonzero`, `finite`, or a comparison
+                             such as `> 1e-6` (with `>`, `>=`, `<`, `<=`, `==`, `!=`)
+        :type value_filter:  str
+
+        """
+
+        # fold args into kwargs by using the value as the key and the implict value is None
+        for arg in args:
+            kwargs[arg] = None
+
+        # replace any potential place holders in the query with the query params
+        query = apply_query_params(query, kwargs, True)
+
+        super(Gcam, self).get_data_chunked(query, chunk_size, lambda data_dict: callback(DataFrame(data_dict)), value_filter or "")
+
+    def export_data(self, queries, path, format="csv", *args, value_filter=None, **kwargs):
+        """Runs queries against a running instance of GCAM and writes the
+           results directly to files without first converting them to a
+           DataFrame.
+           Note unlike `get_data` the results are NOT aggregated.
+
+        :param queries: A single GCAM fusion query or a dict of file name to
+                        query to export several at once
+        :type queries:  str or dict(str: str)
+        :param path:    The file to write when given a single query otherwise
+                        the directory in which to write each of the queries
+                        as <name>.<format>
+        :type path:     str
+        :param format:  The file format to write which is one of "csv",
+                        "feather", or "parquet" where the last two are only
+                        available if gcamwrapper was built with Arrow support
+        :type format:   str
+        :param *args: User options to translate placeholder expressions which will
+                      will be added to the kwargs as dict(arg: None)
+        :type *args:  str
+        :param **kargs: User options to translate placeholder expressions which will
+                        get combined with *args and passed on to apply_query_params
+        :type **kargs:  key = arrary(str)
+        :param value_filter: If not None drop values before they are recorded
+                             unless they pass all of the `,` separated conditions
+                             which may be `nonzero`, `finite`, or a comparison
+                             such as `> 1e-6` (with `>`, `>=`, `<`, `<=`, `==`, `!=`)
+        :type value_filter:  str
+        :returns: The list of files written
+
+        """
+
+        # the format argument is named for parity with R but shadows the builtin
+        # so use a different name from here on
+        file_format = format
+
+        # fold args into kwargs by using the value as the key and the implict value is None
+        for arg in args:
+            kwargs[arg] = None
+
+        if isinstance(queries, str):
+            files = {path: queries}
+        else:
+            makedirs(path, exist_ok=True)
+            ext = super(Gcam, self).get_export_file_extension(file_format)
+            files = {join(path, name + ext): query for name, query in queries.items()}
+
+        for file_name, query in files.items():
+            # replace any potential place holders in the query with the query params
+            query = apply_query_params(query, kwargs, True)
+            super(Gcam, self).export_data(query, file_name, file_format, value_filter or "")
+
+        return list(files.keys())
+
+    def get_data_delta(self, query, *args, tolerance=0.0, **kwargs):
+        """Queries for arbitrary data from a running instance of GCAM but only
+           returns the rows which changed since the last time this was called
+           with the same query.  The previous results are kept in GCAM so the
+           comparison happens without transfering the unchanged rows.
+           The first call returns all of the results and any rows which are no
+           longer found are returned with a value of NaN.
+
+        :param query:   GCAM fusion query
+        :type query:    str
+        :param *args: User options to translate placeholder expressions which will
+                      will be added to the kwargs as dict(arg: None)
+        :type *args:  str
+        :param tolerance: Values which changed by no more than this absolute
+                          amount are not returned
+        :type tolerance:  float
+        :param **kargs: User options to translate placeholder expressions which will
+                        get combined with *args and passed on to apply_query_params
+        :type **kargs:  key = arrary(str)
+
+        :returns:       DataFrame with the changed results which are already
+                        aggregated.
+
+        """
+
+        # fold args into kwargs by using the value as the key and the implict value is None
+        for arg in args:
+            kwargs[arg] = None
+
+        # replace any potential place holders in the query with the query params
+        query = apply_query_params(query, kwargs, True)
+
+        return DataFrame(super(Gcam, self).get_data_delta(query, tolerance))
+
+    def reset_data_delta(self, query=None, *args, **kwargs):
+        """Forget the previous results kept by `get_data_delta` so that the next
+           call returns all of the results again.
+
+        :param query:   The GCAM fusion query to reset, with the same query params
+                        as given to `get_data_delta`, or None to reset all
+        :type query:    str
+        :param *args: User options to translate placeholder expressions which will
+                      will be added to the kwargs as dict(arg: None)
+        :type *args:  str
+        :param **kargs: User options to translate placeholder expressions which will
+                        get combined with *args and passed on to apply_query_params
+        :type **kargs:  key = arrary(str)
+        """
+
+        if query is None:
+            super(Gcam, self).reset_data_delta("")
+            return
+
+        # fold args into kwargs by using the value as the key and the implict value is None
+        for arg in args:
+            kwargs[arg] = None
+
+        super(Gcam, self).reset_data_delta(apply_query_params(query, kwargs, True))
+
     def set_data(self, data_df, query, *args, **kwargs):
         """Changes arbitrary data in a running instance of GCAM.
 
@@ -120,15 +537,7 @@ class Gcam(gcam_module.gcam):
 
         # we need to transform the data from a DataFrame to a dict where the column
         # name key maps to the column as a numpy array
-        data_dict = dict()
-        for key, value in data_df.items():
-            data_as_numpy = value.to_numpy()
-            if data_as_numpy.dtype == np.int64:
-                data_as_numpy = data_as_numpy.astype(np.int32)
-                if key != "year" and key != "period":
-                    warnings.warn(f"Implict conversion to int32 for {key} may result in loss of data")
-            data_dict[key] = data_as_numpy
-        super(Gcam, self).set_data(data_dict, query)
+        super(Gcam, self).set_data(_data_frame_to_dict(data_df), query)
 
     def set_data_fast(self, data_df, query, *args, **kwargs):
         """Set some aribtrary data into GCAM using an optimized routine
@@ -138,6 +547,10 @@ class Gcam(gcam_module.gcam):
            to perform a `get_data` call, then does a left join (essentially, using hashes for speed)
            on those queried values with the supplied data frame to match in the new values to set
            back into GCAM.
+           The data may also be given in a wide format, such as returned by `get_data` with
+           `wide=True`, where the path columns are followed by a value column for each year
+           named by the year.  In this case each row sets the whole vector of data at once and
+           any missing (NaN) values are left unchanged.
 
         :param data_df:     DataFrame of data to set
         :type data_df:      DataFrame
@@ -163,15 +576,140 @@ class Gcam(gcam_module.gcam):
 
         # we need to transform the data from a DataFrame to a dict where the column
         # name key maps to the column as a numpy array
-        data_dict = dict()
-        for key, value in data_df.items():
-            data_as_numpy = value.to_numpy()
-            if data_as_numpy.dtype == np.int64:
-                data_as_numpy = data_as_numpy.astype(np.int32)
-                if key != "year" and key != "period":
-                    warnings.warn(f"Implict conversion to int32 for {key} may result in loss of data")
-            data_dict[key] = data_as_numpy
-        super(Gcam, self).set_data_fast(data_dict, query)
+        super(Gcam, self).set_data_fast(_data_frame_to_dict(data_df), query)
+
+    def run_ensemble(self, members, period, queries, *args, n_workers=0, **kwargs):
+        """Run an ensemble of model runs in parallel without initializing the model again
+           Each member is run in a worker process forked from this one which starts
+           from a copy of the model as it is now, sets the member's data with
+           `set_data_fast`, runs to `period`, and hands back the results of `queries`.
+           The model in this process is not changed.  Not available on Windows.
+           A worker could deadlock if any other thread is running when it is
+           forked so this is refused if this process has other threads, which is
+           the case once a period has been run when GCAM is built with TBB or
+           Java, or once a multi-threaded BLAS has been loaded which numpy does
+           on import.  Set the environment variable `OPENBLAS_NUM_THREADS=1`
+           before importing numpy to keep OpenBLAS to a single thread, and with
+           TBB run the ensemble before any period has been run in this process.
+           Otherwise use `run_period` for each member in turn.
+
+        :param members: A list with an entry for each member which is a list of
+                        (query, DataFrame) tuples of data to set for that member
+        :type members:  list(list(tuple(str, DataFrame)))
+        :param period:  The GCAM model period each member should run to
+        :type period:   int
+        :param queries: The queries to get the results of from each member given as
+                        either a dict of name to query or a list of query library
+                        paths, as in `print_xmldb`
+        :type queries:  dict(str: str) or list(tuple(str))
+        :param *args: User options to translate placeholder expressions which will
+                      will be added to the kwargs as dict(arg: None)
+        :type *args:  str
+        :param n_workers: The maximum number of worker processes to run at once or
+                          0 to use the number of cores available
+        :type n_workers:  int
+        :param **kargs: User options to translate placeholder expressions which
+                        are only applied to the queries which have that placeholder
+        :type **kargs:  key = arrary(str)
+        :returns: A list with an entry for each member which is a dict of query name
+                  to DataFrame, aggregated as in `get_data`, or None if the member failed
+        """
+
+        # fold args into kwargs by using the value as the key and the implict value is None
+        for arg in args:
+            kwargs[arg] = None
+
+        def apply_relevant_params(query):
+            # only apply the filters relevant to this query
+            placeholders = find_placeholders(query)
+            query_params = {param: value for param, value in kwargs.items() if param in placeholders}
+            return apply_query_params(query, query_params, True)
+
+        if not isinstance(queries, dict):
+            queries = {"_".join(path): get_query(*path) for path in queries}
+
+        param_members = []
+        param_queries = []
+        param_data = []
+        for member, member_params in enumerate(members):
+            for query, data_df in member_params:
+                param_members.append(member)
+                param_queries.append(apply_relevant_params(query))
+                param_data.append(_data_frame_to_dict(data_df))
+
+        params_dict = {"member": np.array(param_members, dtype=np.int32), "query": np.array(param_queries, dtype=object)}
+        queries_dict = {"name": np.array(list(queries.keys()), dtype=object),
+                        "query": np.array([apply_relevant_params(query) for query in queries.values()], dtype=object)}
+        results = super(Gcam, self).run_ensemble(param_data, params_dict, len(members), period, queries_dict, n_workers)
+
+        # a failed member will have the error message, which was already warned about
+        return [dict(zip(queries.keys(), [_aggregate_data(data) for data in result])) if isinstance(result, list) else None
+                for result in results]
+
+    def sensitivity(self, param_query, output_queries, period=None, step=1e-4, *args, n_workers=1, **kwargs):
+        """Calculate the sensitivity of outputs to parameters by finite differences
+           Each value found by `param_query` is perturbed in turn by `step` times
+           its absolute value, or just `step` if it is zero, then `period` is
+           re-solved starting from the base solution and the outputs collected.
+           The parameters and the base solution are restored once done.  Note
+           only `period` is re-solved, earlier periods are kept as is.
+
+        :param param_query: GCAM fusion query for the parameters to perturb
+        :type param_query:  str
+        :param output_queries: The queries for the outputs given as either a dict
+                               of name to query or a list of query library paths,
+                               as in `print_xmldb`
+        :type output_queries:  dict(str: str) or list(tuple(str))
+        :param period:  The GCAM model period to calculate sensitivities for which
+                        will be run first if needed, defaults to the current period
+        :type period:   int
+        :param step:    The relative size of the perturbation
+        :type step:     float
+        :param *args: User options to translate placeholder expressions which will
+                      will be added to the kwargs as dict(arg: None)
+        :type *args:  str
+        :param n_workers: The maximum number of perturbations to run at once in
+                          forked worker processes (see `run_ensemble`), or 0 to
+                          use the number of cores available.  If workers can not
+                          be forked, such as when this process has other threads
+                          running, the perturbations are run in this process
+                          instead with a warning, as they are when this is 1
+        :type n_workers:  int
+        :param **kargs: User options to translate placeholder expressions which
+                        are only applied to the queries which have that placeholder
+        :type **kargs:  key = arrary(str)
+        :returns: A dict with "params", a DataFrame of the parameters with their
+                  base value and step, "outputs", a dict of query name to
+                  DataFrame of the base outputs, and "jacobians", a dict of query
+                  name to an array of the derivatives with a row for each row of
+                  the outputs and a column for each parameter.  Note the params and
+                  outputs are not aggregated so that the rows line up with the
+                  jacobians.
+        """
+
+        if period is None:
+            period = self.get_current_period()
+
+        # fold args into kwargs by using the value as the key and the implict value is None
+        for arg in args:
+            kwargs[arg] = None
+
+        def apply_relevant_params(query):
+            # only apply the filters relevant to this query
+            placeholders = find_placeholders(query)
+            query_params = {param: value for param, value in kwargs.items() if param in placeholders}
+            return apply_query_params(query, query_params, True)
+
+        if not isinstance(output_queries, dict):
+            output_queries = {"_".join(path): get_query(*path) for path in output_queries}
+
+        queries_dict = {"name": np.array(list(output_queries.keys()), dtype=object),
+                        "query": np.array([apply_relevant_params(query) for query in output_queries.values()], dtype=object)}
+        params, outputs, jacobians = super(Gcam, self).sensitivity(apply_relevant_params(param_query), queries_dict,
+                                                                   period, step, n_workers)
+        return {"params": DataFrame(params),
+                "outputs": dict(zip(output_queries.keys(), [DataFrame(output) for output in outputs])),
+                "jacobians": dict(zip(output_queries.keys(), jacobians))}
 
     def get_current_period(self):
         """Get the last run GCAM model period
@@ -217,14 +755,61 @@ class Gcam(gcam_module.gcam):
         else:
             return list(map(lambda x: self.convert_year_to_period(x), year))
 
-    def print_xmldb(self, xmldb_location = ""):
+    def print_xmldb(self, xmldb_location = "", queries=None, format="csv", *args, **kwargs):
         """Write the full results to an XML Database
            At the moment all of the options governing XML Database output are
            locked into the values set in the `configuration` as well as the
            `XMLDBDriver.properties` file.
+           Alternatively, if `queries` are given only the results of those
+           queries are written, one file per query, into the directory
+           `xmldb_location` which is much faster and smaller than writing
+           the full XML Database.
+
+        :param xmldb_location: Override the location to write the XMLDB if
+                               non-empty, or the directory to write the selected
+                               queries which defaults to the scenario name
+        :type xmldb_location:  str
+        :param queries: If not None only write these queries given as either a
+                        dict of file name to query or a list of query library
+                        paths such as `[("emissions", "co2_emissions")]` in
+                        which case the path joined with "_" is the file name
+        :type queries:  dict(str: str) or list(tuple(str))
+        :param format:  The file format used to write selected queries which is
+                        one of "csv", "feather", or "parquet" (see `export_data`)
+        :type format:   str
+        :param *args: User options to translate placeholder expressions which will
+                      will be added to the kwargs as dict(arg: None)
+        :type *args:  str
+        :param **kargs: User options to translate placeholder expressions, such as
+                        region or sector filters, which are only applied to the
+                        queries which have that placeholder
+        :type **kargs:  key = arrary(str)
+        :returns: The XMLDB location or directory written to
         """
 
-        return super(Gcam, self).print_xmldb(xmldb_location)
+        if queries is None:
+            return super(Gcam, self).print_xmldb(xmldb_location)
+
+        # fold args into kwargs by using the value as the key and the implict value is None
+        for arg in args:
+            kwargs[arg] = None
+
+        if not isinstance(queries, dict):
+            queries = {"_".join(path): get_query(*path) for path in queries}
+
+        names = []
+        fusion_queries = []
+        for name, query in queries.items():
+            # only apply the filters relevant to this query
+            placeholders = find_placeholders(query)
+            query_params = {param: value for param, value in kwargs.items() if param in placeholders}
+            names.append(name)
+            fusion_queries.append(apply_query_params(query, query_params, True))
+
+        location = xmldb_location if xmldb_location != "" else self.get_scenario_name()
+        makedirs(location, exist_ok=True)
+        queries_dict = {"name": np.array(names, dtype=object), "query": np.array(fusion_queries, dtype=object)}
+        return super(Gcam, self).print_selected(queries_dict, location, format)
 
     def get_scenario_name(self):
         return super(Gcam, self).get_scenario_name()
@@ -232,6 +817,66 @@ class Gcam(gcam_module.gcam):
     def set_scenario_name(self, name):
         super(Gcam, self).set_scenario_name(name)
 
+    def get_solver_trace(self):
+        """Get the record of recent attempts to solve model periods.
+           An entry is recorded each time a period is solved by `run_period`
+           including the worst market left by the solver.  Only the most recent
+           entries are kept, see `set_solver_trace_capacity`.
+
+        :returns: DataFrame with the columns attempt, a running count of solver
+                  attempts (not solver iterations), period, method, success,
+                  max_relative_ed, worst_market, elapsed (seconds) the time to
+                  run the period including initializing it, the climate model,
+                  and feedbacks, or for solve_markets just the time to solve,
+                  and model_calcs the number of model calculations over the
+                  same scope, which measures the solver effort.  Note there is
+                  one entry per attempt, not per solver iteration, and the
+                  solver components used are not available
+        """
+
+        return DataFrame(super(Gcam, self).get_solver_trace())
+
+    def get_market_states(self, market_filter="", start_period=None, end_period=None):
+        """Get the price, supply, and demand of all markets, or those whose name
+           matches `market_filter`, over a range of model periods in a single call.
+           This reads the markets directly and is much faster than using
+           `get_data` or creating a SolutionDebugger for each period.
+
+        :param market_filter: A regular expression market names must match, the
+                              default of an empty string includes all markets
+        :type market_filter:  str
+        :param start_period:  The first model period to include or None to start
+                              from the first model period
+        :type start_period:   int
+        :param end_period:    The last model period to include or None to include
+                              through the last model period
+        :type end_period:     int
+
+        :returns: DataFrame with the columns market, period, price, supply, demand,
+                  and solvable (1 if the market is solvable)
+        """
+
+        if start_period is None:
+            start_period = -1
+        if end_period is None:
+            end_period = -1
+        return DataFrame(super(Gcam, self).get_market_states(market_filter, start_period, end_period))
+
+    def set_solver_trace_capacity(self, capacity):
+        """Set the maximum number of solver attempts to keep in the solver trace.
+
+        :param capacity: The number of entries to keep, the oldest entries will
+                         be dropped first
+        :type capacity: int
+        """
+
+        super(Gcam, self).set_solver_trace_capacity(capacity)
+
+    def clear_solver_trace(self):
+        """Remove all entries from the solver trace."""
+
+        super(Gcam, self).clear_solver_trace()
+
 
     def create_solution_debugger(self, period=None, market_filter="solvable"):
         """Create a solution debugging object which can be used a single
@@ -254,6 +899,55 @@ class Gcam(gcam_module.gcam):
         sd.__class__ = SolutionDebugger
         return sd
 
+    def refresh_solution_debugger(self, sd):
+        """Update the prices, scale factors, and F(x) of a debugger to reflect
+           the current state of the model, for instance after it has been
+           re-solved or had data changed, which is much cheaper than creating a
+           new debugger.  If the markets which pass the market filter have
+           changed the debugger is rebuilt as if it were newly created.  Note,
+           this may invalidate scaled prices / quantities a user may have
+           already stored.  A debugger for a period other than the one whose
+           feedbacks are being run can not be refreshed.
+
+        :param sd:       A SolutionDebugger created from this instance
+        :type sd:        SolutionDebugger
+
+        :returns:        If the set of solvable markets changed.
+
+        """
+
+        return super(Gcam, self).refresh_solution_debugger(sd)
+
+    def solve_markets(self, market_filter, period=None, max_iter=20, tol=1e-3):
+        """Solve only the markets which pass `market_filter`, holding the prices
+           of all other markets at their current values, using Newton's method.
+           This is useful for perturbation studies where a change only affects a
+           few markets as it is much faster than re-solving the entire period.
+           The solve stops if no step improves the solution and the prices are
+           left at the best found.  If the period has already been run it is
+           marked as dirty, as its post calculations, climate model, and
+           feedbacks are not updated, see `rerun_from_earliest_dirty`.
+
+        :param market_filter: A `<solution-info-filter>` string in the same
+                              format as in the solver config XML to select the
+                              markets to solve.
+        :type market_filter:  str
+        :param period:        GCAM model period to solve or if None use the last
+                              run model period.
+        :type period:         integer
+        :param max_iter:      The maximum number of Newton iterations.
+        :type max_iter:       integer
+        :param tol:           The largest absolute scaled F(x) which is considered
+                              solved.
+        :type tol:            float
+
+        :returns:             If the markets were solved.
+        """
+
+        if period is None:
+            period = self.get_current_period()
+        return super(Gcam, self).solve_markets(period, market_filter, max_iter, tol)
+
 
 class SolutionDebugger (gcam_module.SolutionDebugger):
     """An object that exposes certain parts of the GCAM solver allowing users
@@ -420,6 +1114,33 @@ class SolutionDebugger (gcam_module.SolutionDebugger):
                          index=super(SolutionDebugger, self).get_market_names(),
                          columns=super(SolutionDebugger, self).get_market_names())
 
+    def calc_newton_diagnostics(self, n_groups=3, n_markets=5):
+        """Calculates the Jacobian matrix from the set of prices currently set in
+           the solver, as `calc_derivative` does, but rather than returning it
+           computes the Newton step and conditioning diagnostics.  The
+           ill-conditioned groups are found from the singular vectors of the
+           smallest singular values of the Jacobian and list the markets which
+           contribute the most to each, which are the markets the solver will
+           have the most trouble solving together.
+
+        :param n_groups:  The number of smallest singular values to report
+                          markets for, zero skips this calculation.
+        :type n_groups:   integer
+        :param n_markets: The number of markets to report for each group.
+        :type n_markets:  integer
+
+        :returns:   A dict with the Newton `step` (in scaled prices) as a Series
+                    indexed by market name, `rcond` an estimate of the reciprocal
+                    condition number of the Jacobian, and `ill_conditioned` a
+                    DataFrame with the columns group, singular_value, market, and
+                    weight.
+        """
+
+        step, rcond, ill_conditioned = super(SolutionDebugger, self).calc_newton_diagnostics(n_groups, n_markets)
+        return {"step": Series(step, super(SolutionDebugger, self).get_market_names()),
+                "rcond": rcond,
+                "ill_conditioned": DataFrame(ill_conditioned)}
+
     def get_slope(self):
         """Get the "correction" slope, which is used by the solver to give
            continous behavior when a price for a market falls below the
@@ -0,0 +1,85 @@
+#ifndef __ENSEMBLE_RUNNER_H__
+#define __ENSEMBLE_RUNNER_H__
+
+#include "interp_interface.h"
+#include "query_result_writer.h"
+
+#include <string>
+#include <vector>
+#include <functional>
+
+/*!
+ * \brief A QueryResultWriter which serializes query results into an in memory
+ *        buffer so that they can be handed between processes.
+ * \details Any number of tables may be written to the same buffer by calling
+ *          endTable after the columns of each.  The tables can then be read back
+ *          in the same order with readTable.
+ */
+class SerializingResultWriter : public QueryResultWriter {
+public:
+  virtual void addColumn(const std::string& aName, const std::vector<std::string>& aData);
+
+  virtual void addColumn(const std::string& aName, const std::vector<int>& aData);
+
+  virtual void addColumn(const std::string& aName, const std::vector<double>& aData);
+
+  virtual void write(const std::string& aFileName);
+
+  void endTable();
+
+  const std::string& getBuffer() const;
+
+  static Interp::DataFrame readTable(const char*& aPos, const char* aEnd);
+
+private:
+  //! The serialized tables which have been completed
+  std::string mBuffer;
+
+  //! The serialized columns of the table currently being written
+  std::string mCurrTable;
+
+  //! The number of columns in mCurrTable
+  size_t mNumCols = 0;
+};
+
+/*!
+ * \brief Run the members of an ensemble in forked worker processes.
+ * \details The workers are forked from the calling process so they inherit the
+ *          already initialized model copy-on-write and no member has to pay the
+ *          cost to initialize again.  Each worker runs a single member and hands
+ *          back its results through a POSIX shared memory object before exiting,
+ *          any changes the member made to the model are lost with it.  At most
+ *          the given number of workers will be running at once.
+ *          Note no other threads may be running in this process when a worker
+ *          is forked, including those of TBB, Java, or a BLAS library loaded by
+ *          numpy, which is checked by canFork where the platform allows it, and
+ *          this is not available on Windows.
+ */
+class EnsembleRunner {
+public:
+  //! Run the member with the given index, serializing the results into the
+  //! given buffer, any exception thrown is reported as the member's error
+  typedef std::function<void(const size_t, std::string&)> MemberFunction;
+
+  //! Handle the results of the member with the given index, called in the
+  //! parent process with either the buffer the member wrote or an error message
+  typedef std::function<void(const size_t, const bool, const char*, const size_t)> ResultFunction;
+
+  EnsembleRunner(const int aNumWorkers);
+
+  static bool canFork(std::string& aReason);
+
+  void run(const size_t aNumMembers, const MemberFunction& aMemberFunc, const ResultFunction& aResultFunc);
+
+private:
+  //! The maximum number of worker processes to run at once
+  size_t mNumWorkers;
+
+  std::string getSharedMemoryName(const size_t aMember) const;
+
+  void runMember(const size_t aMember, const std::string& aSharedMemoryName, const MemberFunction& aMemberFunc) const;
+
+  void collectMember(const size_t aMember, const int aStatus, const ResultFunction& aResultFunc) const;
+};
+
+#endif // __ENSEMBLE_RUNNER_H__
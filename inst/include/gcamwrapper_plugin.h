@@ -0,0 +1,66 @@
+#ifndef __GCAMWRAPPER_PLUGIN_H__
+#define __GCAMWRAPPER_PLUGIN_H__
+
+/*!
+ * \file gcamwrapper_plugin.h
+ * \brief The interface a shared library must implement to be loaded as a
+ *        gcamwrapper plugin.
+ * \details A plugin couples a compiled model with GCAM at the same points a user
+ *          could with the `post_init_calback` of `run_period` but without calling
+ *          back into the interpreter.  The shared library must export the function
+ *          GCAMWRAPPER_PLUGIN_ENTRY_NAME with C linkage which returns a pointer to
+ *          a static GcamwrapperPlugin describing it, for instance:
+ *
+ *          extern "C" const GcamwrapperPlugin* gcamwrapper_plugin() {
+ *              static const GcamwrapperPlugin plugin = { GCAMWRAPPER_PLUGIN_API_VERSION,
+ *                  "my-model", &create, &destroy, &postInit, &afterPeriod };
+ *              return &plugin;
+ *          }
+ *
+ *          Any of the hooks may be null if not needed.  The Scenario is given as is
+ *          so a plugin which needs to interact with it must be built against the same
+ *          GCAM headers and libgcam as gcamwrapper.
+ */
+
+class Scenario;
+
+//! The version of this interface, a plugin built against a different version
+//! will not be loaded
+#define GCAMWRAPPER_PLUGIN_API_VERSION 1
+
+//! The name of the function a plugin must export
+#define GCAMWRAPPER_PLUGIN_ENTRY_NAME "gcamwrapper_plugin"
+
+extern "C" {
+
+struct GcamwrapperPlugin {
+    //! Must be set to GCAMWRAPPER_PLUGIN_API_VERSION
+    int mAPIVersion;
+
+    //! A name to identify the plugin by in messages
+    const char* mName;
+
+    //! Create an instance of the plugin given the options string the user
+    //! passed when loading it, returns the state which is passed to all of the
+    //! other hooks or null if it failed
+    void* (*mCreate)(const char* aOptions);
+
+    //! Clean up the state created by mCreate
+    void (*mDestroy)(void* aState);
+
+    //! Called for each model period once it has been initialized but before it
+    //! is solved, returns null on success or else an error message which must
+    //! remain valid until the next call into the plugin
+    const char* (*mPostInit)(void* aState, Scenario* aScenario, const int aPeriod);
+
+    //! Called for each model period once it has been solved and the climate
+    //! model run, returns null on success or else an error message as above
+    const char* (*mAfterPeriod)(void* aState, Scenario* aScenario, const int aPeriod);
+};
+
+//! The signature of the function a plugin must export
+typedef const GcamwrapperPlugin* (*GcamwrapperPluginEntry)();
+
+}
+
+#endif // __GCAMWRAPPER_PLUGIN_H__
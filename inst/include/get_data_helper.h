@@ -5,9 +5,15 @@
 #include "query_processor_base.h"
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <map>
+
+#include <boost/container_hash/hash.hpp>
 
 class Scenario;
 class AMatcherWrapper;
+class QueryResultWriter;
+class ValueFilter;
 
 /*!
  * \brief A GCAM Fusion class that will run arbitrary queries and organize the
@@ -19,13 +25,32 @@ class AMatcherWrapper;
  *          correspond with each value returned by the query result.  Note the DataFrame
  *          generated from this class will not be "aggregated" for unique identifying
  *          column combinations, that step will be left to be done in the interpreter.
+ *          The same instance may be run any number of times so that the parsed query
+ *          and the memory for the results can be reused.
  */
 class GetDataHelper : public QueryProcessorBase {
 public:
-  GetDataHelper(const std::string& aQuery);
+  GetDataHelper(const std::string& aQuery, const std::string& aValueFilter = "", const bool aProfile = false);
+  ~GetDataHelper();
 
   Interp::DataFrame run( Scenario* aScenario);
 
+  void runChunked( Scenario* aScenario, const size_t aChunkSize, const Interp::Function& aCallback );
+
+  void runExport( Scenario* aScenario, QueryResultWriter& aWriter );
+
+  Interp::DataFrame runDelta( Scenario* aScenario, const double aTolerance );
+
+  Interp::DataFrame runWide( Scenario* aScenario );
+
+  const std::vector<double>& runValues( Scenario* aScenario );
+
+  void releaseData( const size_t aMaxRetainedRows );
+
+  Interp::List runProfile( Scenario* aScenario, const double aSetupTime );
+
+  size_t runCount( Scenario* aScenario, const bool aCountAnyType );
+
   template<typename T>
   void processData(T& aData);
 protected:
@@ -35,12 +60,76 @@ protected:
   //! The data for the value column which match the query
   std::vector<double> mDataVector;
 
+  //! The number of rows at which to hand results off to mChunkCallback
+  //! or zero to collect all results
+  size_t mChunkSize;
+
+  //! The interpreter function to call with each chunk of results
+  const Interp::Function* mChunkCallback;
+
+  //! An optional filter on the values found by the query so that rows which
+  //! would be discarded anyways are never recorded, null if not set
+  ValueFilter* mValueFilter;
+
+  //! A map of the interned path values, one per path tracker, to the value
+  //! summed over all data found with that path
+  typedef std::unordered_map<std::vector<int>, double, boost::hash<std::vector<int> > > DeltaMap;
+
+  //! If set, values are summed into mDeltaCurr as the query runs rather than
+  //! being recorded so that only changes may be reported
+  bool mIsDelta;
+
+  //! The results from the current run of runDelta
+  DeltaMap mDeltaCurr;
+
+  //! The results from the previous run of runDelta
+  DeltaMap mDeltaPrev;
+
+  //! If set, each vector of data found is recorded as a single row with the
+  //! years as columns
+  bool mIsWide;
+
+  //! If set, values which would be recorded are only counted in mNumCounted
+  bool mIsCount;
+
+  //! If set when counting, data of types which could not be recorded are
+  //! counted rather than being an error
+  bool mCountAnyType;
+
+  //! The number of values found when counting
+  size_t mNumCounted;
+
+  //! The year of the value currently being processed from a vector of data
+  //! or NO_WIDE_YEAR if not processing a vector
+  int mWideYear;
+
+  //! If the next value recorded from a vector of data starts a new wide row
+  bool mIsNewWideRow;
+
+  //! The number of rows recorded in wide mode
+  size_t mNumWideRows;
+
+  //! The wide value columns by year, which are padded with NaN as needed
+  std::map<int, std::vector<double> > mWideData;
+
+  //! The value of mWideYear when not processing a vector
+  static const int NO_WIDE_YEAR = -1;
+
   //! A flag to help with the implicit behavior that if a user forgot
   //! to add year filter on a period vector of data we can implicitly
   //! add one that matches all for them
   bool mHasYearInPath;
 
   virtual AMatchesValue* wrapPredicate(AMatchesValue* aToWrap, const std::string& aDataName, const bool aIsInt);
+
+  Interp::DataFrame createDataFrame() const;
+
+  void clearData();
+
+  void recordValue(const double aValue);
+
+  void recordRow(const std::vector<int>& aPathIDs, const double aValue);
+
   template<typename VecType>
   void vectorDataHelper(VecType& aDataVec);
 };
@@ -3,6 +3,7 @@
 
 #include <exception>
 #include <string>
+#include <vector>
 
 // use boost::iostreams to wrap Interp API for cout
 #include <boost/iostreams/stream.hpp>
@@ -65,6 +66,8 @@ namespace Interp {
     using Rcpp::StringVector;
     using Rcpp::IntegerVector;
     using Rcpp::NumericMatrix;
+    using Rcpp::Function;
+    using Rcpp::List;
 
     inline std::string extract(const Rcpp::String& aStr) {
         return aStr;
@@ -84,13 +87,34 @@ namespace Interp {
     inline int getDataFrameNumRows(const DataFrame& aDataFrame) {
       return aDataFrame.nrow();
     }
+    inline std::vector<std::string> getDataFrameNames(const DataFrame& aDataFrame) {
+      return Rcpp::as<std::vector<std::string> >(aDataFrame.names());
+    }
+
+    inline List createList(const int aSize) {
+      return List(aSize);
+    }
+    inline int getListSize(const List& aList) {
+      return aList.size();
+    }
+    template<typename T>
+    inline T getListAt(const List& aList, const int aIndex) {
+      return Rcpp::as<T>(aList[aIndex]);
+    }
+    template<typename T>
+    inline void setListAt(List& aList, const int aIndex, const T& aValue) {
+      aList[aIndex] = aValue;
+    }
 
     template<typename DataType, typename VectorType>
     VectorType createVector(int aSize) {
       return VectorType(aSize);
     }
+    inline NumericMatrix createNumericMatrix(int aNumRows, int aNumCols) {
+      return NumericMatrix(aNumRows, aNumCols);
+    }
     inline NumericMatrix createNumericMatrix(int aSize) {
-      return NumericMatrix(aSize, aSize);
+      return createNumericMatrix(aSize, aSize);
     }
     template<typename VectorType>
     inline void setVectorNames(VectorType& aVector, const StringVector& aNames) {
@@ -102,15 +126,19 @@ namespace Interp {
     }
     using Rcpp::wrap;
     template<typename MatrixType>
-    NumericMatrix wrapMatrix(const MatrixType& aData, int aSize) {
-      NumericMatrix ret = createNumericMatrix(aSize);
-      for(int row = 0; row < aSize; ++row) {
-        for(int col = 0; col < aSize; ++col) {
+    NumericMatrix wrapMatrix(const MatrixType& aData, int aNumRows, int aNumCols) {
+      NumericMatrix ret = createNumericMatrix(aNumRows, aNumCols);
+      for(int row = 0; row < aNumRows; ++row) {
+        for(int col = 0; col < aNumCols; ++col) {
           ret.at(row, col) = aData(row, col);
         }
       }
       return ret;
     }
+    template<typename MatrixType>
+    NumericMatrix wrapMatrix(const MatrixType& aData, int aSize) {
+      return wrapMatrix(aData, aSize, aSize);
+    }
 }
 
 #elif defined(PY_VERSION_HEX)
@@ -194,6 +222,8 @@ namespace Interp {
     using StringVector = NumpyVecWrapper<bp::str>;
     using IntegerVector = NumpyVecWrapper<int>;
     using NumericMatrix = bnp::ndarray;
+    using Function = bp::object;
+    using List = bp::list;
 
     inline DataFrame createDataFrame() {
         DataFrame ret;
@@ -210,6 +240,33 @@ namespace Interp {
         bnp::ndarray vec0 = bp::extract<bnp::ndarray>(aDataFrame.values()[0]);
         return vec0.shape(0);
     }
+    inline std::vector<std::string> getDataFrameNames(const DataFrame& aDataFrame) {
+        bp::list keys = aDataFrame.keys();
+        std::vector<std::string> ret(bp::len(keys));
+        for(size_t i = 0; i < ret.size(); ++i) {
+            ret[i] = bp::extract<std::string>(keys[i]);
+        }
+        return ret;
+    }
+
+    inline List createList(const int aSize) {
+        List ret;
+        for(int i = 0; i < aSize; ++i) {
+            ret.append(bp::object());
+        }
+        return ret;
+    }
+    inline int getListSize(const List& aList) {
+        return bp::len(aList);
+    }
+    template<typename T>
+    inline T getListAt(const List& aList, const int aIndex) {
+        return bp::extract<T>(aList[aIndex]);
+    }
+    template<typename T>
+    inline void setListAt(List& aList, const int aIndex, const T& aValue) {
+        aList[aIndex] = aValue;
+    }
 
     template<typename DataType>
     bnp::dtype interp_get_dtype() {
@@ -226,8 +283,11 @@ namespace Interp {
     VectorType createVector(int aSize) {
         return bnp::empty(bp::make_tuple(aSize), interp_get_dtype<DataType>());
     }
+    inline NumericMatrix createNumericMatrix(int aNumRows, int aNumCols) {
+        return bnp::empty(bp::make_tuple(aNumRows, aNumCols), bnp::dtype::get_builtin<double>());
+    }
     inline NumericMatrix createNumericMatrix(int aSize) {
-        return bnp::empty(bp::make_tuple(aSize, aSize), bnp::dtype::get_builtin<double>());
+        return createNumericMatrix(aSize, aSize);
     }
     inline void setVectorNames(bnp::ndarray& aVector, const StringVector& aNames) {
     }
@@ -257,19 +317,23 @@ namespace Interp {
     }
 
     template<typename MatrixType>
-    NumericMatrix wrapMatrix(const MatrixType& aData, int aSize) {
-        NumericMatrix ret = createNumericMatrix(aSize);
+    NumericMatrix wrapMatrix(const MatrixType& aData, int aNumRows, int aNumCols) {
+        NumericMatrix ret = createNumericMatrix(aNumRows, aNumCols);
         double* retData = reinterpret_cast<double*>(ret.get_data());
-        const size_t row_stride = aSize;
+        const size_t row_stride = aNumCols;
         double* row_iter = retData;
-        for(int i = 0; i < aSize; ++i, row_iter += row_stride) {
+        for(int i = 0; i < aNumRows; ++i, row_iter += row_stride) {
             double* col_iter = row_iter;
-            for (int j = 0; j < aSize; ++j, ++col_iter) {
+            for (int j = 0; j < aNumCols; ++j, ++col_iter) {
                 *col_iter = aData(i, j);
             }
         }
         return ret;
     }
+    template<typename MatrixType>
+    NumericMatrix wrapMatrix(const MatrixType& aData, int aSize) {
+        return wrapMatrix(aData, aSize, aSize);
+    }
 
 }
 
@@ -0,0 +1,43 @@
+#ifndef __MARKET_STATE_COLLECTOR_H__
+#define __MARKET_STATE_COLLECTOR_H__
+
+#include "interp_interface.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <regex>
+
+#include "util/base/include/default_visitor.h"
+
+class Marketplace;
+
+/*!
+ * \brief Collects the price, supply, and demand of markets directly from the
+ *        marketplace.
+ * \details Unlike GetDataHelper this does not need to walk the whole model with
+ *          GCAM Fusion and instead just visits the markets, which makes it cheap
+ *          to get the state of all markets over many periods at once.  The
+ *          results are collected into columns as they are found.
+ */
+class MarketStateCollector : public DefaultVisitor {
+public:
+  MarketStateCollector(const std::string& aMarketFilter);
+
+  Interp::DataFrame collect(const Marketplace* aMarketplace, const int aStartPeriod, const int aEndPeriod);
+
+  virtual void startVisitMarket(const Market* aMarket, const int aPeriod);
+
+private:
+  //! A regular expression market names must match, or null to include all
+  std::unique_ptr<std::regex> mMarketFilter;
+
+  // the collected columns
+  std::vector<std::string> mMarket;
+  std::vector<int> mPeriod;
+  std::vector<double> mPrice;
+  std::vector<double> mSupply;
+  std::vector<double> mDemand;
+  std::vector<int> mSolvable;
+};
+
+#endif // __MARKET_STATE_COLLECTOR_H__
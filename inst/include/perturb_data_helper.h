@@ -0,0 +1,52 @@
+#ifndef __PERTURB_DATA_HELPER_H__
+#define __PERTURB_DATA_HELPER_H__
+
+#include "interp_interface.h"
+#include "query_processor_base.h"
+#include <string>
+#include <vector>
+
+class Scenario;
+
+/*!
+ * \brief A GCAM Fusion class to read or overwrite individual values found by a
+ *        query, identified by the order in which the query finds them.
+ * \details The query syntax is the same as for GetDataHelper and the values are
+ *          found in the same order, so the rows given by GetDataHelper for the same
+ *          query identify the values here.  This allows a single value to be
+ *          perturbed and restored without needing to build a DataFrame to set it.
+ */
+class PerturbDataHelper : public QueryProcessorBase {
+public:
+  PerturbDataHelper(const std::string& aQuery);
+
+  const std::vector<double>& getValues(Scenario* aScenario);
+
+  void setValue(Scenario* aScenario, const size_t aIndex, const double aValue);
+
+  template<typename T>
+  void processData(T& aData);
+protected:
+  //! The index of the next value the query will find
+  size_t mCurrIndex;
+
+  //! The index of the value to set, or NO_TARGET to collect all values
+  size_t mTargetIndex;
+
+  //! The value to set at mTargetIndex
+  double mTargetValue;
+
+  //! The values collected by getValues
+  std::vector<double> mValues;
+
+  //! The value of mTargetIndex when collecting values
+  static const size_t NO_TARGET;
+
+  template<typename DataType>
+  void visitData(DataType& aData);
+
+  template<typename VecType>
+  void vectorDataHelper(VecType& aDataVec);
+};
+
+#endif // __PERTURB_DATA_HELPER_H__
@@ -0,0 +1,58 @@
+#ifndef __PLUGIN_MANAGER_H__
+#define __PLUGIN_MANAGER_H__
+
+#include "interp_interface.h"
+#include "gcamwrapper_plugin.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+/*!
+ * \brief Loads gcamwrapper plugins from shared libraries and calls their hooks
+ *        as model periods are run.
+ * \details See gcamwrapper_plugin.h for the interface a plugin must implement.
+ *          Plugins are called in the order they were loaded and are unloaded
+ *          when this object is destroyed.
+ */
+class PluginManager {
+public:
+  PluginManager();
+  ~PluginManager();
+
+  // unloading is only safe once
+  PluginManager(const PluginManager&) = delete;
+  PluginManager& operator=(const PluginManager&) = delete;
+
+  void load(const std::string& aPath, const std::string& aOptions);
+
+  void clear();
+
+  bool empty() const;
+
+  std::vector<std::string> getNames() const;
+
+  std::string postInit(Scenario* aScenario, const int aPeriod);
+
+  std::string afterPeriod(Scenario* aScenario, const int aPeriod);
+
+private:
+  //! A plugin which has been loaded along with its state
+  struct LoadedPlugin {
+    //! The handle from dlopen
+    void* mLibrary;
+    //! The description the plugin gave
+    const GcamwrapperPlugin* mPlugin;
+    //! The state created by the plugin
+    void* mState;
+  };
+
+  //! The plugins in the order they were loaded
+  std::vector<LoadedPlugin> mPlugins;
+
+  static void unload(const LoadedPlugin& aPlugin);
+
+  static std::string formatError(const LoadedPlugin& aPlugin, const char* aError, const char* aHook);
+};
+
+#endif // __PLUGIN_MANAGER_H__
@@ -0,0 +1,73 @@
+#ifndef __PRICE_CHECKPOINT_H__
+#define __PRICE_CHECKPOINT_H__
+
+#include "interp_interface.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+
+/*!
+ * \brief Keeps a checkpoint of the solved prices of each model period so that a
+ *        run which fails can be resumed from the last completed period.
+ * \details GCAM does not have a way to save its full state, however the solution
+ *          of a period is determined by the model inputs and the solved prices.
+ *          So a run can be resumed by running each checkpointed period again
+ *          starting the solver from the checkpointed prices, which converges
+ *          immediately, rather than having to solve from scratch.
+ *          When a file is set the checkpoint is written to it each time a period
+ *          is recorded.  The write happens in a background thread, to a temporary
+ *          file which is then renamed over the checkpoint, so a crash at any point
+ *          leaves the last complete checkpoint in place.
+ */
+class PriceCheckpoint {
+public:
+  PriceCheckpoint();
+  ~PriceCheckpoint();
+
+  PriceCheckpoint(const PriceCheckpoint&) = delete;
+  PriceCheckpoint& operator=(const PriceCheckpoint&) = delete;
+
+  void setFile(const std::string& aFile);
+
+  const std::string& getFile() const;
+
+  void disable();
+
+  void setSuspended(const bool aSuspended);
+
+  void record(const int aPeriod);
+
+  void wait();
+
+  void read(const std::string& aFile);
+
+  int getLastPeriod() const;
+
+  void restore(const int aPeriod) const;
+
+private:
+  //! The name and price of each solvable market in a period
+  typedef std::vector<std::pair<std::string, double> > MarketPrices;
+
+  //! The checkpointed prices by model period
+  std::map<int, MarketPrices> mPeriods;
+
+  //! The file to write the checkpoint to, or empty if disabled
+  std::string mFile;
+
+  //! If set, record does nothing while the model is temporarily moved away from
+  //! the solution being checkpointed
+  bool mSuspended;
+
+  //! The thread writing the checkpoint, if any
+  std::thread mWriter;
+
+  //! An error message from the last write, only safe to read once mWriter is joined
+  std::string mWriteError;
+
+  static void write(const std::string& aFile, const std::map<int, MarketPrices>& aPeriods, std::string& aError);
+};
+
+#endif // __PRICE_CHECKPOINT_H__
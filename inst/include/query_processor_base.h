@@ -1,11 +1,16 @@
 #ifndef __QUERY_PROCESSOR_BASE_H__
 #define __QUERY_PROCESSOR_BASE_H__
 
+#include "interp_interface.h"
+
 #include <string>
 #include <vector>
+#include <limits>
 
 struct FilterStep;
 class AMatchesValue;
+class YearTracker;
+class StepProfiler;
 
 /*!
  * \brief The base class for the Get and Set Data query processor
@@ -23,8 +28,23 @@ class AMatchesValue;
  */
 class QueryProcessorBase {
 public:
-  QueryProcessorBase() {}
+  QueryProcessorBase():mTrackYears(false), mEarliestSetYear(NO_DATA_SET), mPushDownYearRange(false),
+    mYearRangeMatcher(0), mYearRangeStart(std::numeric_limits<int>::min()), mYearRangeEnd(std::numeric_limits<int>::max()),
+    mProfile(false), mNumDataSet(0) {}
   virtual ~QueryProcessorBase();
+
+  //! The value of getEarliestSetYear() if no data was set
+  static const int NO_DATA_SET;
+  //! The value of getEarliestSetYear() if data was set without a year in the path
+  //! and therefore may affect all model periods
+  static const int ALL_YEARS_SET;
+
+  int getEarliestSetYear() const;
+
+  size_t getNumDataSet() const;
+
+  Interp::List createProfile(const double aSetupTime, const double aTraversalTime, const double aConversionTime,
+                             const size_t aNumLeaves) const;
 protected:
   //! The GCAM Fusion Filter Steps which is a fully parsed query
   std::vector<FilterStep*> mFilterSteps;
@@ -32,6 +52,52 @@ protected:
   //! The column name corresponding to the data to be get/set
   std::string mDataColName;
 
+  //! A flag which subclasses may set before parsing to keep track of the years
+  //! matched by any YearFilter so that markDataSet can determine which years were set
+  bool mTrackYears;
+
+  //! The year filters which keep track of the last year they matched
+  std::vector<YearTracker*> mYearTrackers;
+
+  //! The earliest year of data which has been set by this query
+  int mEarliestSetYear;
+
+  //! A flag which subclasses may set before parsing to take a `+` YearFilter on
+  //! the last step out of the GCAM Fusion filter steps so that the subclass can
+  //! only visit the years of a vector of data in [mYearRangeStart, mYearRangeEnd]
+  //! rather than having GCAM Fusion test every element
+  bool mPushDownYearRange;
+
+  //! The predicate taken from the last filter step if it was pushed down which
+  //! still needs to be checked for each year in range, or null if none
+  AMatchesValue* mYearRangeMatcher;
+
+  //! The first year which could match mYearRangeMatcher
+  int mYearRangeStart;
+
+  //! The last year which could match mYearRangeMatcher
+  int mYearRangeEnd;
+
+  //! A flag which subclasses may set before parsing to wrap the predicate of
+  //! each filter step so that the work done by each step is recorded, see
+  //! createProfile
+  bool mProfile;
+
+  //! The unparsed filter step strings and the profiler of their predicate, or
+  //! null if the step has no predicate, only set if mProfile is set
+  std::vector<std::pair<std::string, StepProfiler*> > mStepProfiles;
+
+  //! The number of times markDataSet has been called
+  size_t mNumDataSet;
+
+  AMatchesValue* trackYear(AMatchesValue* aToWrap);
+
+  AMatchesValue* profilePredicate(AMatchesValue* aToWrap, const std::string& aFilterStepStr);
+
+  void markDataSet();
+
+  void setYearRange(const std::vector<std::string>& aFilterOptions);
+
   void parseFilterString(const std::string& aFilterStr );
 
   FilterStep* parseFilterStepStr( const std::string& aFilterStepStr, int& aCol, const bool aIsLastStep );
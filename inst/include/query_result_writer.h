@@ -0,0 +1,38 @@
+#ifndef __QUERY_RESULT_WRITER_H__
+#define __QUERY_RESULT_WRITER_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#ifndef __HAVE_ARROW__
+#define __HAVE_ARROW__ 0
+#endif
+
+/*!
+ * \brief An interface to write the columns of a query result directly to a file
+ *        without first converting them to an interpreter DataFrame.
+ * \details Columns are added in the order they should appear in the file.  The
+ *          writer does not take ownership of the column data which must remain
+ *          valid until write is called.  The available formats are "csv" and, if
+ *          gcamwrapper was built with Arrow support, "feather" (Arrow IPC) and
+ *          "parquet".
+ */
+class QueryResultWriter {
+public:
+  virtual ~QueryResultWriter() {}
+
+  virtual void addColumn(const std::string& aName, const std::vector<std::string>& aData) = 0;
+
+  virtual void addColumn(const std::string& aName, const std::vector<int>& aData) = 0;
+
+  virtual void addColumn(const std::string& aName, const std::vector<double>& aData) = 0;
+
+  virtual void write(const std::string& aFileName) = 0;
+
+  static std::unique_ptr<QueryResultWriter> create(const std::string& aFormat);
+
+  static std::string getFileExtension(const std::string& aFormat);
+};
+
+#endif // __QUERY_RESULT_WRITER_H__
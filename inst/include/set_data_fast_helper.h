@@ -7,6 +7,7 @@
 #include <vector>
 #include <map>
 #include <list>
+#include <unordered_map>
 
 class Scenario;
 class AMatcherHashWrapper;
@@ -24,7 +25,7 @@ class AMatcherHashWrapper;
  */
 class SetDataFastHelper : public QueryProcessorBase {
 public:
-  SetDataFastHelper(const Interp::DataFrame& aData, const std::string& aQuery);
+  SetDataFastHelper(const Interp::DataFrame& aData, const std::string& aQuery, const bool aProfile = false);
 
   void run( Scenario* aScenario );
 
@@ -38,13 +39,32 @@ protected:
 
   //! The data for the value column which match the query
   std::list<std::vector<size_t> > mTempDataID;
-  std::map<size_t, double> mDataVector;
+  std::unordered_map<size_t, double> mDataVector;
+
+  //! If the data is in a wide format with the path columns followed by a
+  //! value column for each year, named by the year
+  bool mIsWide;
+
+  //! The number of path columns in mData when mIsWide
+  int mNumPathCols;
+
+  //! The years of the value columns in increasing order when mIsWide
+  std::vector<int> mWideYears;
+
+  //! The value columns corresponding to mWideYears when mIsWide
+  std::vector<Interp::NumericVector> mWideValues;
+
+  //! The hash of the path columns to the row in mData when mIsWide
+  std::unordered_map<size_t, size_t> mWideRows;
 
   virtual AMatchesValue* wrapPredicate(AMatchesValue* aToWrap, const std::string& aDataName, const bool aIsInt);
   virtual AMatchesValue* parsePredicate( const std::vector<std::string>& aFilterOptions, const int aCol, const bool aIsRead ) const;
 
   template<typename VecType>
   void vectorDataHelper(VecType& aDataVec);
+
+  template<typename VecType>
+  void wideVectorDataHelper(VecType& aDataVec);
 };
 
 #endif // __SET_DATA_FAST_HELPER_H__
@@ -20,7 +20,7 @@ struct FilterStep;
  */
 class SetDataHelper : public QueryProcessorBase {
 public:
-  SetDataHelper(const Interp::DataFrame& aData, const std::string& aQuery);
+  SetDataHelper(const Interp::DataFrame& aData, const std::string& aQuery, const bool aProfile = false);
 
   void run(Scenario* aScenario);
 
@@ -3,18 +3,28 @@
 
 #include "interp_interface.h"
 
+#include <memory>
+
 #include "solution/util/include/solution_info_set.h"
 #include "solution/util/include/edfun.hpp"
 #include "solution/util/include/ublas-helpers.hpp"
 
 class World;
 class Marketplace;
+class ISolutionInfoFilter;
 
 class SolutionDebugger {
 public:
-  static SolutionDebugger createInstance(const int aPeriod, const std::string& aMarketFilterStr);
+  static SolutionDebugger createInstance(const int aPeriod, const std::string& aMarketFilterStr,
+                                         std::shared_ptr<unsigned long> aModelGeneration);
+
+  SolutionDebugger(World *w, Marketplace *m, std::shared_ptr<SolutionInfoSet> sisin,
+                   std::shared_ptr<ISolutionInfoFilter> filter, int per,
+                   std::shared_ptr<unsigned long> generation);
 
-  SolutionDebugger(World *w, Marketplace *m, SolutionInfoSet &sisin, int per);
+  bool refresh();
+
+  int getPeriod() const;
 
   Interp::StringVector getMarketNames();
 
@@ -48,6 +58,10 @@ public:
 
   Interp::NumericMatrix calcDerivative();
 
+  Interp::List calcNewtonDiagnostics(const int aNumGroups, const int aNumMarkets);
+
+  bool solve(const int aMaxIter, const double aTolerance);
+
   Interp::NumericVector getSlope();
 
   void setSlope(const Interp::NumericVector& aDX);
@@ -63,13 +77,22 @@ private:
 
   World* world;
   Marketplace* marketplace;
-  SolutionInfoSet solnInfoSet;
+  // shared so that copies of this object remain valid as F refers to solnInfoSet
+  std::shared_ptr<SolutionInfoSet> solnInfoSet;
+  std::shared_ptr<ISolutionInfoFilter> solnFilter;
   int period;
   unsigned int nsolv;
-  LogEDFun F;
+  std::shared_ptr<LogEDFun> F;
   UBVECTOR x;
   UBVECTOR fx;
   Interp::StringVector marketNames;
+  // incremented each time we evaluate the model so the owner knows any
+  // results it has cached are out of date
+  std::shared_ptr<unsigned long> modelGeneration;
+
+  void rebuild();
+
+  void markModelChanged();
 };
 
 #endif // __SOLUTION_DEBUGGER_H__
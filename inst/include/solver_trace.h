@@ -0,0 +1,61 @@
+#ifndef __SOLVER_TRACE_H__
+#define __SOLVER_TRACE_H__
+
+#include "interp_interface.h"
+#include <string>
+
+#include <boost/circular_buffer.hpp>
+
+/*!
+ * \brief Keeps a bounded history of solver attempts so users can find slow
+ *        or failing periods without parsing the log output.
+ * \details Each time the wrapper asks GCAM to solve a period an entry is
+ *          recorded with the wall clock time it took, the number of model
+ *          calculations the solver needed, as well as the worst market (by
+ *          relative excess demand) left once the solver returned.  Note there is
+ *          one entry per attempt rather than per solver iteration and the solver
+ *          components used are not included as GCAM's solver does not expose them,
+ *          the number of model calculations is the measure of solver effort.
+ *          The entries are kept in a ring buffer so the oldest are dropped
+ *          once the capacity is reached.
+ */
+class SolverTrace {
+public:
+  SolverTrace(const size_t aCapacity);
+
+  void record(const int aPeriod, const std::string& aMethod, const bool aSuccess, const double aElapsed,
+              const double aNumCalcs);
+
+  void setCapacity(const size_t aCapacity);
+
+  void clear();
+
+  Interp::DataFrame getDataFrame() const;
+
+private:
+  //! A single solver attempt
+  struct Entry {
+    //! A running count of solver attempts, gaps indicate dropped entries
+    int mAttempt;
+    int mPeriod;
+    //! Which wrapper call triggered the solve
+    std::string mMethod;
+    bool mSuccess;
+    //! The maximum absolute relative excess demand of solvable markets
+    double mMaxRelED;
+    //! The name of the market with mMaxRelED
+    std::string mWorstMarket;
+    //! Wall clock time in seconds to run the period
+    double mElapsed;
+    //! The number of times the model was calculated
+    double mNumCalcs;
+  };
+
+  //! The ring buffer of recorded attempts
+  boost::circular_buffer<Entry> mEntries;
+
+  //! The number of attempts recorded so far
+  int mNumAttempts;
+};
+
+#endif // __SOLVER_TRACE_H__
@@ -0,0 +1,60 @@
+#ifndef __YEAR_RANGE_H__
+#define __YEAR_RANGE_H__
+
+#include <iterator>
+#include <limits>
+
+#include "util/base/include/gcam_fusion.hpp"
+
+/*!
+ * \brief Find the first element of a year indexed vector of data whose year is
+ *        at least aYear.
+ * \details All of the ARRAY types GCAM Fusion can hand us (PeriodVector,
+ *          TechVintageVector, YearVector, etc) are ordered by year so we can
+ *          do a binary search using GetIndexAsYear to convert positions to years.
+ * \param aDataVec The vector of data to search.
+ * \param aYear The year to search for.
+ * \return An iterator to the first element with a year >= aYear or end().
+ */
+template<typename VecType>
+auto findFirstYear(VecType& aDataVec, const int aYear) -> decltype(aDataVec.begin()) {
+  auto first = aDataVec.begin();
+  auto count = std::distance(first, aDataVec.end());
+  while(count > 0) {
+    auto step = count / 2;
+    auto iter = first;
+    std::advance(iter, step);
+    if(GetIndexAsYear::convertIterToYear(aDataVec, iter) < aYear) {
+      first = ++iter;
+      count -= step + 1;
+    }
+    else {
+      count = step;
+    }
+  }
+  return first;
+}
+
+/*!
+ * \brief Call aFunc for only the elements of a year indexed vector of data which
+ *        fall within [aStartYear, aEndYear].
+ * \param aDataVec The vector of data to visit.
+ * \param aStartYear The first year to include, or the min int to start at the beginning.
+ * \param aEndYear The last year to include, or the max int to go through to the end.
+ * \param aFunc A callable which takes the iterator to the element and the year
+ *              of that element.
+ */
+template<typename VecType, typename FuncType>
+void forEachInYearRange(VecType& aDataVec, const int aStartYear, const int aEndYear, FuncType aFunc) {
+  auto iter = aStartYear == std::numeric_limits<int>::min() ?
+    aDataVec.begin() : findFirstYear(aDataVec, aStartYear);
+  for(; iter != aDataVec.end(); ++iter) {
+    const int year = GetIndexAsYear::convertIterToYear(aDataVec, iter);
+    if(year > aEndYear) {
+      break;
+    }
+    aFunc(iter, year);
+  }
+}
+
+#endif // __YEAR_RANGE_H__
@@ -29,6 +29,14 @@ else:
     JAVA_INCLUDE = os.environ["JAVA_INCLUDE"]
     JAVA_PLATFORM_INCLUDE = JAVA_INCLUDE + '/' + os.uname()[0].lower()
     JAVA_LIB = os.environ["JAVA_LIB"]
+if 'HAVE_ARROW' in os.environ and os.environ['HAVE_ARROW'] == '1':
+    HAVE_ARROW = True
+    have_arrow_macro = '1'
+    ARROW_INCLUDE = os.environ["ARROW_INCLUDE"]
+    ARROW_LIB = os.environ["ARROW_LIB"]
+else:
+    HAVE_ARROW = False
+    have_arrow_macro = '0'
 
 gcam_include_dirs = ['inst/include', GCAM_INCLUDE, BOOST_INCLUDE, TBB_INCLUDE, EIGEN_INCLUDE]
 gcam_lib_dirs = [GCAM_LIB, BOOST_LIB, TBB_LIB]
@@ -38,6 +46,10 @@ if HAVE_JAVA:
     gcam_include_dirs.extend([JAVA_INCLUDE, JAVA_PLATFORM_INCLUDE])
     gcam_lib_dirs.append(JAVA_LIB) 
     gcam_libs.append('jvm')
+if HAVE_ARROW:
+    gcam_include_dirs.append(ARROW_INCLUDE)
+    gcam_lib_dirs.append(ARROW_LIB)
+    gcam_libs.extend(['arrow', 'parquet'])
 gcam_compile_args = []
 gcam_link_args = []
 if platform.system() == "Windows" :
@@ -54,6 +66,12 @@ else :
     gcam_link_args += ['-Wl,-rpath,'+BOOST_LIB, '-Wl,-rpath,'+TBB_LIB]
     if HAVE_JAVA:
         gcam_link_args.append('-Wl,-rpath,'+JAVA_LIB)
+    if HAVE_ARROW:
+        gcam_link_args.append('-Wl,-rpath,'+ARROW_LIB)
+    if platform.system() == "Linux":
+        # shm_open used by the ensemble runner needs librt and dlopen used
+        # to load plugins needs libdl on older glibc
+        gcam_libs.extend(['rt', 'dl'])
 
 gcam_module = Extension(
     'gcam_module',
@@ -62,7 +80,14 @@ gcam_module = Extension(
         'src/query_processor_base.cpp',
         'src/set_data_helper.cpp',
         'src/set_data_fast_helper.cpp',
-        'src/get_data_helper.cpp'],
+        'src/get_data_helper.cpp',
+        'src/solver_trace.cpp',
+        'src/query_result_writer.cpp',
+        'src/ensemble_runner.cpp',
+        'src/perturb_data_helper.cpp',
+        'src/plugin_manager.cpp',
+        'src/market_state_collector.cpp',
+        'src/price_checkpoint.cpp'],
     include_dirs=gcam_include_dirs,
     library_dirs=gcam_lib_dirs,
     libraries=gcam_libs,
@@ -72,7 +97,8 @@ gcam_module = Extension(
                    ('BOOST_MATH_TR1_NO_LIB', '1'),
                    ('BOOST_PYTHON_STATIC_LIB', '1'),
                    ('BOOST_NUMPY_STATIC_LIB', '1'),
-                   ('__HAVE_JAVA__', have_java_macro)],
+                   ('__HAVE_JAVA__', have_java_macro),
+                   ('__HAVE_ARROW__', have_arrow_macro)],
     extra_link_args=gcam_link_args,
     language='c++',
     extra_compile_args = gcam_compile_args
@@ -0,0 +1,391 @@
+#include "interp_interface.h"
+
+#include "ensemble_runner.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <chrono>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <dirent.h>
+#endif
+
+using namespace std;
+
+namespace {
+  //! The type tags for the serialized columns
+  enum ColumnType : uint8_t {
+    STRING_COL = 0,
+    INT_COL = 1,
+    DOUBLE_COL = 2
+  };
+
+  //! The first byte in the shared memory indicating if the member succeeded
+  //! and the rest is the results or an error message
+  enum MemberStatus : uint8_t {
+    MEMBER_FAILED = 0,
+    MEMBER_SUCCEEDED = 1
+  };
+
+  //! How long to wait between checking if any workers have finished
+  const int WAIT_INTERVAL_MS = 10;
+
+  void writeSize(std::string& aBuffer, const uint64_t aSize) {
+    aBuffer.append(reinterpret_cast<const char*>(&aSize), sizeof(aSize));
+  }
+
+  void writeString(std::string& aBuffer, const std::string& aValue) {
+    writeSize(aBuffer, aValue.size());
+    aBuffer.append(aValue);
+  }
+
+  template<typename T>
+  void writeNumbers(std::string& aBuffer, const std::vector<T>& aData) {
+    writeSize(aBuffer, aData.size());
+    aBuffer.append(reinterpret_cast<const char*>(aData.data()), aData.size() * sizeof(T));
+  }
+
+#if !defined(_WIN32)
+  /*!
+   * \brief Count the threads running in this process.
+   * \return The number of threads or -1 if it can not be determined on this
+   *         platform.
+   */
+  int countThreads() {
+    DIR* tasks = opendir("/proc/self/task");
+    if(!tasks) {
+      return -1;
+    }
+    int numThreads = 0;
+    while(struct dirent* entry = readdir(tasks)) {
+      if(entry->d_name[0] != '.') {
+        ++numThreads;
+      }
+    }
+    closedir(tasks);
+    return numThreads;
+  }
+#endif
+
+  void checkAvailable(const char* aPos, const char* aEnd, const size_t aSize) {
+    if(static_cast<size_t>(aEnd - aPos) < aSize) {
+      Interp::stop("Serialized query results were truncated.");
+    }
+  }
+
+  uint64_t readSize(const char*& aPos, const char* aEnd) {
+    uint64_t ret;
+    checkAvailable(aPos, aEnd, sizeof(ret));
+    memcpy(&ret, aPos, sizeof(ret));
+    aPos += sizeof(ret);
+    return ret;
+  }
+
+  std::string readString(const char*& aPos, const char* aEnd) {
+    const uint64_t size = readSize(aPos, aEnd);
+    checkAvailable(aPos, aEnd, size);
+    std::string ret(aPos, size);
+    aPos += size;
+    return ret;
+  }
+
+  template<typename T>
+  std::vector<T> readNumbers(const char*& aPos, const char* aEnd) {
+    const uint64_t size = readSize(aPos, aEnd);
+    checkAvailable(aPos, aEnd, size * sizeof(T));
+    std::vector<T> ret(size);
+    memcpy(ret.data(), aPos, size * sizeof(T));
+    aPos += size * sizeof(T);
+    return ret;
+  }
+}
+
+void SerializingResultWriter::addColumn(const std::string& aName, const std::vector<std::string>& aData) {
+  mCurrTable.push_back(STRING_COL);
+  writeString(mCurrTable, aName);
+  writeSize(mCurrTable, aData.size());
+  for(const auto& value : aData) {
+    writeString(mCurrTable, value);
+  }
+  ++mNumCols;
+}
+
+void SerializingResultWriter::addColumn(const std::string& aName, const std::vector<int>& aData) {
+  mCurrTable.push_back(INT_COL);
+  writeString(mCurrTable, aName);
+  writeNumbers(mCurrTable, aData);
+  ++mNumCols;
+}
+
+void SerializingResultWriter::addColumn(const std::string& aName, const std::vector<double>& aData) {
+  mCurrTable.push_back(DOUBLE_COL);
+  writeString(mCurrTable, aName);
+  writeNumbers(mCurrTable, aData);
+  ++mNumCols;
+}
+
+/*!
+ * \brief Write the serialized tables to a file as is.
+ * \param aFileName The file to write.
+ */
+void SerializingResultWriter::write(const std::string& aFileName) {
+  ofstream out(aFileName.c_str(), ios::binary);
+  out.write(mBuffer.data(), mBuffer.size());
+  if(!out) {
+    Interp::stop("Failed while writing "+aFileName);
+  }
+}
+
+/*!
+ * \brief Complete the table whose columns have been added since the last call.
+ */
+void SerializingResultWriter::endTable() {
+  writeSize(mBuffer, mNumCols);
+  mBuffer.append(mCurrTable);
+  mCurrTable.clear();
+  mNumCols = 0;
+}
+
+const std::string& SerializingResultWriter::getBuffer() const {
+  return mBuffer;
+}
+
+/*!
+ * \brief Read the next table out of a buffer written by a SerializingResultWriter.
+ * \param aPos The position in the buffer to start reading, which will be updated
+ *             to the start of the next table.
+ * \param aEnd The end of the buffer.
+ * \return The table as a DataFrame with the columns in the order they were added.
+ */
+Interp::DataFrame SerializingResultWriter::readTable(const char*& aPos, const char* aEnd) {
+  Interp::DataFrame ret = Interp::createDataFrame();
+  const uint64_t numCols = readSize(aPos, aEnd);
+  for(uint64_t col = 0; col < numCols; ++col) {
+    checkAvailable(aPos, aEnd, 1);
+    const uint8_t type = *aPos++;
+    const std::string name = readString(aPos, aEnd);
+    if(type == STRING_COL) {
+      std::vector<std::string> data(readSize(aPos, aEnd));
+      for(auto& value : data) {
+        value = readString(aPos, aEnd);
+      }
+      ret[name] = Interp::wrap(data);
+    }
+    else if(type == INT_COL) {
+      ret[name] = Interp::wrap(readNumbers<int>(aPos, aEnd));
+    }
+    else if(type == DOUBLE_COL) {
+      ret[name] = Interp::wrap(readNumbers<double>(aPos, aEnd));
+    }
+    else {
+      Interp::stop("Unknown column type in serialized query results.");
+    }
+  }
+  return ret;
+}
+
+/*!
+ * \brief Constructor.
+ * \param aNumWorkers The maximum number of worker processes to run at once or
+ *                    zero or less to use the number of cores available.
+ */
+EnsembleRunner::EnsembleRunner(const int aNumWorkers):mNumWorkers(aNumWorkers)
+{
+  if(aNumWorkers <= 0) {
+    mNumWorkers = std::max(1u, std::thread::hardware_concurrency());
+  }
+}
+
+/*!
+ * \brief Check if ensemble workers can safely be forked from this process.
+ * \details Only the forking thread exists in a worker so if any other thread
+ *          holds a lock, such as in the allocator, the TBB scheduler, or a BLAS
+ *          thread pool, the worker could deadlock.  Such threads are started
+ *          once a period has been run when GCAM is built with TBB or Java, and
+ *          by OpenBLAS as soon as it is loaded, for instance when numpy is
+ *          imported unless OPENBLAS_NUM_THREADS=1 was set beforehand.
+ * \param aReason Set to the reason workers can not be forked.
+ * \return Whether workers can be forked.
+ */
+bool EnsembleRunner::canFork(std::string& aReason) {
+#if defined(_WIN32)
+  aReason = "Running an ensemble requires fork which is not available on Windows.";
+  return false;
+#else
+  const int numThreads = countThreads();
+  if(numThreads > 1) {
+    aReason = "Can not fork ensemble workers while "+std::to_string(numThreads)+" threads are running in this process, "+
+              "a worker could deadlock on a lock held by another thread.  These are started by GCAM when built with TBB "+
+              "or Java once a period has been run, and by BLAS libraries such as the OpenBLAS used by numpy unless "+
+              "OPENBLAS_NUM_THREADS=1 is set before it is loaded.";
+    return false;
+  }
+  return true;
+#endif
+}
+
+/*!
+ * \brief Run all of the members of the ensemble.
+ * \details aMemberFunc is called in the worker processes while aResultFunc is
+ *          called in this process as each worker completes, not necessarily in
+ *          the order of the members.
+ * \param aNumMembers The number of members to run.
+ * \param aMemberFunc The function which runs a member.
+ * \param aResultFunc The function which receives the results of a member.
+ */
+void EnsembleRunner::run(const size_t aNumMembers, const MemberFunction& aMemberFunc, const ResultFunction& aResultFunc) {
+  std::string reason;
+  if(!canFork(reason)) {
+    Interp::stop(reason);
+  }
+#if !defined(_WIN32)
+  // flush anything buffered so it is not written again by each worker
+  fflush(nullptr);
+  std::map<pid_t, size_t> running;
+  size_t nextMember = 0;
+  try {
+    while(nextMember < aNumMembers || !running.empty()) {
+      while(nextMember < aNumMembers && running.size() < mNumWorkers) {
+        // the name is determined before forking as it is based on our pid
+        const std::string shmName = getSharedMemoryName(nextMember);
+        pid_t pid = fork();
+        if(pid == 0) {
+          runMember(nextMember, shmName, aMemberFunc);
+        }
+        else if(pid < 0) {
+          Interp::stop("Could not fork an ensemble worker: "+std::string(strerror(errno)));
+        }
+        running[pid] = nextMember++;
+      }
+      // only wait on our own workers so we do not reap any other children the
+      // interpreter may be keeping track of
+      bool anyDone = false;
+      for(auto workerIter = running.begin(); workerIter != running.end(); ) {
+        int status = 0;
+        pid_t pid = waitpid((*workerIter).first, &status, WNOHANG);
+        if(pid == 0 || (pid < 0 && errno == EINTR)) {
+          ++workerIter;
+          continue;
+        }
+        const size_t member = (*workerIter).second;
+        workerIter = running.erase(workerIter);
+        anyDone = true;
+        collectMember(member, status, aResultFunc);
+      }
+      if(!anyDone) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_INTERVAL_MS));
+      }
+    }
+  }
+  catch(...) {
+    // clean up any workers still running before giving up
+    for(const auto& worker : running) {
+      kill(worker.first, SIGKILL);
+      waitpid(worker.first, nullptr, 0);
+      shm_unlink(getSharedMemoryName(worker.second).c_str());
+    }
+    throw;
+  }
+#endif
+}
+
+std::string EnsembleRunner::getSharedMemoryName(const size_t aMember) const {
+#if defined(_WIN32)
+  return "";
+#else
+  return "/gcamwrapper." + std::to_string(getpid()) + "." + std::to_string(aMember);
+#endif
+}
+
+/*!
+ * \brief Run a member in the worker process and hand back the results.
+ * \details This never returns, the worker exits without running any of the
+ *          interpreter's exit handlers once the results are written.
+ * \param aMember The index of the member to run.
+ * \param aSharedMemoryName The name of the shared memory object to create for the results.
+ * \param aMemberFunc The function which runs the member.
+ */
+void EnsembleRunner::runMember(const size_t aMember, const std::string& aSharedMemoryName, const MemberFunction& aMemberFunc) const {
+#if !defined(_WIN32)
+  std::string buffer(1, static_cast<char>(MEMBER_SUCCEEDED));
+  try {
+    aMemberFunc(aMember, buffer);
+  }
+  catch(const std::exception& e) {
+    buffer.assign(1, static_cast<char>(MEMBER_FAILED));
+    buffer.append(e.what());
+  }
+  catch(...) {
+    buffer.assign(1, static_cast<char>(MEMBER_FAILED));
+    buffer.append("Unknown error");
+  }
+
+  int fd = shm_open(aSharedMemoryName.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if(fd < 0 || ftruncate(fd, buffer.size()) != 0) {
+    _exit(EXIT_FAILURE);
+  }
+  void* shm = mmap(nullptr, buffer.size(), PROT_WRITE, MAP_SHARED, fd, 0);
+  if(shm == MAP_FAILED) {
+    _exit(EXIT_FAILURE);
+  }
+  memcpy(shm, buffer.data(), buffer.size());
+  munmap(shm, buffer.size());
+  close(fd);
+  _exit(EXIT_SUCCESS);
+#endif
+}
+
+/*!
+ * \brief Read back the results of a member which has exited and pass them along.
+ * \param aMember The index of the member.
+ * \param aStatus The exit status of the worker as given by waitpid.
+ * \param aResultFunc The function which receives the results.
+ */
+void EnsembleRunner::collectMember(const size_t aMember, const int aStatus, const ResultFunction& aResultFunc) const {
+#if !defined(_WIN32)
+  const std::string shmName = getSharedMemoryName(aMember);
+  int fd = shm_open(shmName.c_str(), O_RDONLY, 0);
+  struct stat shmStat;
+  if(fd < 0 || fstat(fd, &shmStat) != 0 || shmStat.st_size == 0) {
+    if(fd >= 0) {
+      close(fd);
+      shm_unlink(shmName.c_str());
+    }
+    std::string error = WIFSIGNALED(aStatus) ?
+      "Worker was killed by signal " + std::to_string(WTERMSIG(aStatus)) :
+      "Worker failed to hand back results";
+    aResultFunc(aMember, false, error.c_str(), error.size());
+    return;
+  }
+  const size_t size = shmStat.st_size;
+  void* shm = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  shm_unlink(shmName.c_str());
+  if(shm == MAP_FAILED) {
+    std::string error = "Could not map worker results: " + std::string(strerror(errno));
+    aResultFunc(aMember, false, error.c_str(), error.size());
+    return;
+  }
+  const char* data = static_cast<const char*>(shm);
+  try {
+    aResultFunc(aMember, data[0] == MEMBER_SUCCEEDED, data + 1, size - 1);
+  }
+  catch(...) {
+    munmap(shm, size);
+    throw;
+  }
+  munmap(shm, size);
+#endif
+}
@@ -1,6 +1,18 @@
 
 #include "interp_interface.h"
 #include <iostream>
+#include <chrono>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <boost/numeric/ublas/matrix.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
 
 #include "util/base/include/definitions.h"
 #include "util/base/include/configuration.h"
@@ -8,6 +20,7 @@
 #include "containers/include/scenario.h"
 #include "containers/include/iscenario_runner.h"
 #include "containers/include/scenario_runner_factory.h"
+#include "containers/include/single_scenario_runner.h"
 #include "util/logger/include/ilogger.h"
 #include "util/logger/include/logger_factory.h"
 #include "util/base/include/timer.h"
@@ -19,11 +32,19 @@
 #include "containers/include/imodel_feedback_calc.h"
 #include "marketplace/include/marketplace.h"
 #include "containers/include/world.h"
+#include "util/base/include/calc_counter.h"
 
 #include "set_data_helper.h"
 #include "set_data_fast_helper.h"
 #include "get_data_helper.h"
 #include "solution_debugger.h"
+#include "solver_trace.h"
+#include "query_result_writer.h"
+#include "ensemble_runner.h"
+#include "perturb_data_helper.h"
+#include "plugin_manager.h"
+#include "market_state_collector.h"
+#include "price_checkpoint.h"
 
 using namespace std;
 
@@ -33,7 +54,7 @@ Scenario* scenario;
 
 class gcam {
     public:
-        gcam(string aConfiguration):isInitialized(false), mInterpOut(StdoutSink()), mCurrentPeriod(0), mIsMidPeriod(false){
+        gcam(string aConfiguration):isInitialized(false), mInterpOut(StdoutSink()), mCurrentPeriod(0), mIsMidPeriod(false), mSolverTrace(DEFAULT_SOLVER_TRACE_CAPACITY), mPrePeriodElapsed(0), mPrePeriodCalcs(0), mEarliestDirtyPeriod(-1), mDeferClimate(false), mEarliestClimatePending(-1), mLatestClimatePending(-1), mGeneration(new unsigned long(0)), mQueryResultsGeneration(0){
             loggerFactoryWrapper.setCout(&mInterpOut);
             initializeScenario(aConfiguration);
         }
@@ -41,6 +62,8 @@ class gcam {
             Interp::stop("TODO: not sure copying is safe");
         }
         ~gcam() {
+            // plugins may still refer to the scenario so clean them up first
+            mPlugins.clear();
             delete scenario->mManageStateVars;
             scenario->mManageStateVars = 0;
             runner.reset(0);
@@ -55,16 +78,24 @@ class gcam {
             Interp::stop("GCAM did not successfully initialize.");
           }
           Timer timer;
+          markModelChanged();
 
           // we need to set the stop period to ensure Hector does not attempt to
           // run past the current period and then generate superfluous errors
           const string STOP_PERIOD_KEY = "stop-period";
           Configuration* conf = Configuration::getInstance();
-          conf->intMap[STOP_PERIOD_KEY] = aPeriod;
-          bool success = runner->runScenarios(aPeriod, false, timer);
-          if(!success) {
-            Interp::warning("Failed to solve period "+util::toString(aPeriod));
+          // run any previous periods which have not been run one at a time so
+          // that we can keep track of how long each took to solve, other runners
+          // such as for a policy target search over the full run so they must
+          // be given the final period in a single call
+          for(int period = 0; period < aPeriod && isSingleScenarioRunner(); ++period) {
+            if(!scenario->mIsValidPeriod[period]) {
+              conf->intMap[STOP_PERIOD_KEY] = period;
+              runScenariosTraced(period, timer);
+            }
           }
+          conf->intMap[STOP_PERIOD_KEY] = aPeriod;
+          runScenariosTraced(aPeriod, timer);
           mCurrentPeriod = aPeriod;
         }
 
@@ -73,14 +104,17 @@ class gcam {
                 Interp::stop("GCAM did not successfully initialize.");
             }
             Timer timer;
+            markModelChanged();
 
             if(aPeriod > 0 && (mCurrentPeriod+1) < aPeriod) {
-              bool success = runner->runScenarios(aPeriod-1, false, timer);
-              if(!success) {
-                Interp::warning("Failed to solve period "+util::toString(aPeriod));
-              }
+              runScenariosTraced(aPeriod-1, timer);
             }
+            const int prevPeriod = mCurrentPeriod;
             mCurrentPeriod = aPeriod;
+            // time the work done for this period so the solver trace covers the
+            // same scope as when the scenario runner runs the whole period
+            auto preStart = std::chrono::steady_clock::now();
+            const double preCalcs = getCalcCount();
 
             scenario->logPeriodBeginning( aPeriod );
 
@@ -114,10 +148,29 @@ class gcam {
 
     scenario->mWorld->calc( aPeriod ); // call to calculate initial supply and demand
     mIsMidPeriod = true;
+
+    // give any coupled models a chance to update now that we are initialized
+    const std::string pluginError = mPlugins.postInit( scenario, aPeriod );
+    if(!pluginError.empty()) {
+        // abandon the period so the model is not left in the middle of it
+        delete scenario->mManageStateVars;
+        scenario->mManageStateVars = 0;
+        mIsMidPeriod = false;
+        mCurrentPeriod = prevPeriod;
+        Interp::stop(pluginError);
+    }
+    mPrePeriodElapsed = std::chrono::steady_clock::now() - preStart;
+    mPrePeriodCalcs = getCalcCount() - preCalcs;
         }
 
-      void runPeriodPost(const int aPeriod, bool doSolve = true) {
-          bool success = doSolve ? scenario->solve( aPeriod ) : true; // solution uses Bisect and NR routine to clear markets
+      bool runPeriodPost(const int aPeriod, bool doSolve = true) {
+          markModelChanged();
+          auto start = std::chrono::steady_clock::now();
+          const double startCalcs = getCalcCount();
+          bool success = true;
+          if(doSolve) {
+              success = scenario->solve( aPeriod ); // solution uses Bisect and NR routine to clear markets
+          }
 
     scenario->mWorld->postCalc( aPeriod );
 
@@ -130,13 +183,31 @@ class gcam {
         climatelog.setLevel( ILogger::WARNING );
         climatelog << "Solver unsuccessful for period " << aPeriod << "." << endl;
     }
-    scenario->mWorld->runClimateModel( aPeriod );
+    if(mDeferClimate) {
+        // keep track of the periods which will need to be run once the user
+        // asks for the climate model to be run
+        mEarliestClimatePending = mEarliestClimatePending == -1 ? aPeriod : std::min(mEarliestClimatePending, aPeriod);
+        mLatestClimatePending = std::max(mLatestClimatePending, aPeriod);
+    }
+    else {
+        scenario->mWorld->runClimateModel( aPeriod );
+    }
 
     // Call any model feedbacks now that we are done solving the current period and
     // the climate model has been run.
     for( auto modelFeedback : scenario->mModelFeedbacks ) {
         modelFeedback->calcFeedbacksAfterPeriod( scenario, scenario->mWorld->getClimateModel(), aPeriod );
     }
+    // any error is raised once we are done with the period
+    const std::string pluginError = mPlugins.afterPeriod( scenario, aPeriod );
+    if(doSolve) {
+        // include the time spent in run_period_pre but not any time the user
+        // spent in between
+        std::chrono::duration<double> elapsed = mPrePeriodElapsed + (std::chrono::steady_clock::now() - start);
+        mSolverTrace.record(aPeriod, "run_period_post", success, elapsed.count(),
+                            mPrePeriodCalcs + (getCalcCount() - startCalcs));
+    }
+    mCheckpoint.record( aPeriod );
 
     scenario->logPeriodEnding( aPeriod );
 
@@ -150,27 +221,561 @@ class gcam {
     delete scenario->mManageStateVars;
     scenario->mManageStateVars = 0;
     mIsMidPeriod = false;
+    if(!pluginError.empty()) {
+        Interp::stop(pluginError);
+    }
+    return success;
       }
       void setData(const Interp::DataFrame& aData, const std::string& aHeader) {
         if(!isInitialized) {
           Interp::stop("GCAM did not successfully initialize.");
         }
+        markModelChanged();
         SetDataHelper helper(aData, aHeader);
         helper.run(runner->getInternalScenario());
+        updateDirtyPeriod(helper.getEarliestSetYear());
       }
       void setDataFast(const Interp::DataFrame& aData, const std::string& aHeader) {
         if(!isInitialized) {
           Interp::stop("GCAM did not successfully initialize.");
         }
+        markModelChanged();
         SetDataFastHelper helper(aData, aHeader);
         helper.run(runner->getInternalScenario());
+        updateDirtyPeriod(helper.getEarliestSetYear());
+      }
+      Interp::DataFrame getData(const std::string& aHeader, const std::string& aValueFilter) {
+        if(!isInitialized) {
+          Interp::stop("GCAM did not successfully initialize.");
+        }
+        QueryResultKey resultKey(boost::algorithm::trim_copy(aHeader), aValueFilter, false);
+        const Interp::DataFrame* cached = findQueryResult(resultKey);
+        if(cached) {
+            return *cached;
+        }
+        GetDataKey key(aHeader, aValueFilter);
+        std::unique_ptr<GetDataHelper> helper = acquireGetDataHelper(key);
+        Interp::DataFrame ret = helper->run(runner->getInternalScenario());
+        releaseGetDataHelper(key, std::move(helper));
+        addQueryResult(resultKey, ret);
+        return ret;
+      }
+      Interp::DataFrame getDataWide(const std::string& aHeader, const std::string& aValueFilter) {
+        if(!isInitialized) {
+          Interp::stop("GCAM did not successfully initialize.");
+        }
+        QueryResultKey resultKey(boost::algorithm::trim_copy(aHeader), aValueFilter, true);
+        const Interp::DataFrame* cached = findQueryResult(resultKey);
+        if(cached) {
+            return *cached;
+        }
+        GetDataKey key(aHeader, aValueFilter);
+        std::unique_ptr<GetDataHelper> helper = acquireGetDataHelper(key);
+        Interp::DataFrame ret = helper->runWide(runner->getInternalScenario());
+        releaseGetDataHelper(key, std::move(helper));
+        addQueryResult(resultKey, ret);
+        return ret;
+      }
+      Interp::List profileGetData(const std::string& aHeader, const std::string& aValueFilter) {
+        if(!isInitialized) {
+          Interp::stop("GCAM did not successfully initialize.");
+        }
+        // always parse a new helper rather than using the cache so that the
+        // setup cost is included
+        auto start = std::chrono::steady_clock::now();
+        GetDataHelper helper(aHeader, aValueFilter, true);
+        double setupTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return helper.runProfile(runner->getInternalScenario(), setupTime);
+      }
+      Interp::List profileSetData(const Interp::DataFrame& aData, const std::string& aHeader, const bool aFast) {
+        if(!isInitialized) {
+          Interp::stop("GCAM did not successfully initialize.");
+        }
+        markModelChanged();
+        auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<QueryProcessorBase> helper;
+        if(aFast) {
+          helper.reset(new SetDataFastHelper(aData, aHeader, true));
+        }
+        else {
+          helper.reset(new SetDataHelper(aData, aHeader, true));
+        }
+        auto parsed = std::chrono::steady_clock::now();
+        if(aFast) {
+          static_cast<SetDataFastHelper*>(helper.get())->run(runner->getInternalScenario());
+        }
+        else {
+          static_cast<SetDataHelper*>(helper.get())->run(runner->getInternalScenario());
+        }
+        auto traversed = std::chrono::steady_clock::now();
+        updateDirtyPeriod(helper->getEarliestSetYear());
+        // there are no results to organize when setting data
+        return helper->createProfile(std::chrono::duration<double>(parsed - start).count(),
+                                     std::chrono::duration<double>(traversed - parsed).count(),
+                                     0.0, helper->getNumDataSet());
+      }
+      double dryRun(const std::string& aHeader, const std::string& aValueFilter) {
+        if(!isInitialized) {
+          Interp::stop("GCAM did not successfully initialize.");
+        }
+        // parsing will stop on any invalid filter
+        GetDataHelper helper(aHeader, aValueFilter);
+        size_t numRows = helper.runCount(runner->getInternalScenario(), false);
+        if(numRows == 0) {
+          // GCAM Fusion silently finds nothing if a data name does not exist
+          // so find the first step which no longer reaches anything to point
+          // the user to the likely culprit
+          std::vector<std::string> steps;
+          boost::split(steps, aHeader, boost::is_any_of("/"));
+          std::string prefix;
+          bool foundEmpty = false;
+          for(size_t i = 0; i < steps.size() && !foundEmpty; ++i) {
+            prefix += (i == 0 ? "" : "/") + steps[i];
+            if(GetDataHelper(prefix).runCount(runner->getInternalScenario(), true) == 0) {
+              Interp::warning("The query found nothing from step "+std::to_string(i + 1)+" '"+steps[i]+
+                              "', check the data name and filter are valid at that point of the query.");
+              foundEmpty = true;
+            }
+          }
+          if(!foundEmpty) {
+            Interp::warning("The query found values but none passed the value filter.");
+          }
+        }
+        return static_cast<double>(numRows);
+      }
+      void getDataChunked(const std::string& aHeader, const int aChunkSize, const Interp::Function& aCallback, const std::string& aValueFilter) {
+        if(!isInitialized) {
+          Interp::stop("GCAM did not successfully initialize.");
+        }
+        if(aChunkSize <= 0) {
+          Interp::stop("The chunk size must be greater than zero.");
+        }
+        GetDataKey key(aHeader, aValueFilter);
+        std::unique_ptr<GetDataHelper> helper = acquireGetDataHelper(key);
+        helper->runChunked(runner->getInternalScenario(), aChunkSize, aCallback);
+        releaseGetDataHelper(key, std::move(helper));
+      }
+      void exportData(const std::string& aHeader, const std::string& aFileName, const std::string& aFormat, const std::string& aValueFilter) {
+        if(!isInitialized) {
+          Interp::stop("GCAM did not successfully initialize.");
+        }
+        // create the writer first so an unsupported format fails before running the query
+        std::unique_ptr<QueryResultWriter> writer = QueryResultWriter::create(aFormat);
+        GetDataKey key(aHeader, aValueFilter);
+        std::unique_ptr<GetDataHelper> helper = acquireGetDataHelper(key);
+        helper->runExport(runner->getInternalScenario(), *writer);
+        writer->write(aFileName);
+        releaseGetDataHelper(key, std::move(helper));
+      }
+      std::string getExportFileExtension(const std::string& aFormat) const {
+        return QueryResultWriter::getFileExtension(aFormat);
       }
-      Interp::DataFrame getData(const std::string& aHeader) {
+
+      Interp::DataFrame getDataDelta(const std::string& aHeader, const double aTolerance) {
         if(!isInitialized) {
           Interp::stop("GCAM did not successfully initialize.");
         }
-        GetDataHelper helper(aHeader);
-        return helper.run(runner->getInternalScenario());
+        std::unique_ptr<GetDataHelper>& helper = mDeltaQueries[aHeader];
+        if(!helper) {
+          helper.reset(new GetDataHelper(aHeader));
+        }
+        return helper->runDelta(runner->getInternalScenario(), aTolerance);
+      }
+      void resetDataDelta(const std::string& aHeader) {
+        if(aHeader.empty()) {
+          mDeltaQueries.clear();
+        }
+        else {
+          mDeltaQueries.erase(aHeader);
+        }
+      }
+
+      Interp::List sensitivity(const std::string& aParamQuery, const Interp::DataFrame& aOutputQueries, const int aPeriod,
+                               const double aStep, const int aNumWorkers) {
+          if(!isInitialized) {
+              Interp::stop("GCAM did not successfully initialize.");
+          }
+          if(mIsMidPeriod) {
+              Interp::stop("Can not calculate sensitivities while in the middle of running period "+util::toString(mCurrentPeriod));
+          }
+          markModelChanged();
+          if(aPeriod < 0 || aPeriod >= static_cast<int>(scenario->mIsValidPeriod.size())) {
+              Interp::stop("Invalid model period "+util::toString(aPeriod));
+          }
+          if(!(aStep > 0.0)) {
+              Interp::stop("The step must be greater than zero.");
+          }
+          Scenario* currScenario = runner->getInternalScenario();
+          if(!scenario->mIsValidPeriod[aPeriod]) {
+              runPeriod(aPeriod);
+          }
+          // running aPeriod may have moved the model forward
+          const int origPeriod = std::max(mCurrentPeriod, aPeriod);
+          // set the current period so re-solving aPeriod does not run any others
+          mCurrentPeriod = aPeriod;
+
+          // the parameters, the rows of paramInfo identify the values of params
+          GetDataHelper paramInfo(aParamQuery);
+          Interp::DataFrame paramDF = paramInfo.run(currScenario);
+          PerturbDataHelper params(aParamQuery);
+          const std::vector<double> baseParams = params.getValues(currScenario);
+          std::vector<double> steps(baseParams.size());
+          for(size_t param = 0; param < baseParams.size(); ++param) {
+              steps[param] = aStep * (baseParams[param] != 0.0 ? std::abs(baseParams[param]) : 1.0);
+          }
+          paramDF["step"] = Interp::wrap(steps);
+
+          // the outputs at the base solution
+          const int numOutputs = Interp::getDataFrameNumRows(aOutputQueries);
+          std::vector<std::unique_ptr<GetDataHelper> > outputs;
+          std::vector<std::vector<double> > baseOutputs;
+          Interp::List outputDFs = Interp::createList(numOutputs);
+          size_t numOutputValues = 0;
+          if(numOutputs > 0) {
+              Interp::StringVector outputQueries(Interp::getDataFrameAt<Interp::StringVector>(aOutputQueries, 1));
+              for(int i = 0; i < numOutputs; ++i) {
+                  outputs.emplace_back(new GetDataHelper(Interp::extract(outputQueries[i])));
+                  Interp::setListAt(outputDFs, i, outputs[i]->run(currScenario));
+                  baseOutputs.push_back(outputs[i]->runValues(currScenario));
+                  numOutputValues += baseOutputs[i].size();
+              }
+          }
+
+          // perturb a single parameter and re-solve starting from the base solution
+          // then collect all of the outputs one after the other, returns false if
+          // the perturbed model did not solve in which case there are no outputs
+          auto runPerturbed = [&](const size_t aParam, std::vector<double>& aOutputValues) {
+              params.setValue(currScenario, aParam, baseParams[aParam] + steps[aParam]);
+              runPeriodPre(aPeriod, false);
+              if(!runPeriodPost(aPeriod)) {
+                  return false;
+              }
+              aOutputValues.clear();
+              for(size_t i = 0; i < outputs.size(); ++i) {
+                  const std::vector<double>& values = outputs[i]->runValues(currScenario);
+                  if(values.size() != baseOutputs[i].size()) {
+                      Interp::stop("Output query "+util::toString(i)+" found a different number of values when perturbing parameter "+util::toString(aParam));
+                  }
+                  aOutputValues.insert(aOutputValues.end(), values.begin(), values.end());
+              }
+              return true;
+          };
+          // re-solve with the base parameters to get back to the base solution
+          auto restoreBase = [&]() {
+              runPeriodPre(aPeriod, false);
+              if(!runPeriodPost(aPeriod)) {
+                  Interp::warning("Failed to solve period "+util::toString(aPeriod)+
+                                  " when restoring the base parameters, the model is not at its base solution.");
+              }
+          };
+          std::vector<boost::numeric::ublas::matrix<double> > jacobians;
+          for(const auto& baseValues : baseOutputs) {
+              jacobians.emplace_back(baseValues.size(), baseParams.size());
+          }
+          // record the derivatives with respect to a parameter or NaN if the
+          // output values are not available
+          auto recordColumn = [&](const size_t aParam, const double* aOutputValues) {
+              size_t pos = 0;
+              for(size_t i = 0; i < baseOutputs.size(); ++i) {
+                  for(size_t row = 0; row < baseOutputs[i].size(); ++row, ++pos) {
+                      jacobians[i](row, aParam) = aOutputValues ? (aOutputValues[pos] - baseOutputs[i][row]) / steps[aParam] :
+                          std::numeric_limits<double>::quiet_NaN();
+                  }
+              }
+          };
+
+          // the perturbed solutions, and re-solving the base, must not replace the
+          // checkpoint of aPeriod and drop the periods after it
+          struct SuspendCheckpoint {
+              PriceCheckpoint& mCheckpoint;
+              SuspendCheckpoint(PriceCheckpoint& aCheckpoint):mCheckpoint(aCheckpoint) {
+                  mCheckpoint.setSuspended(true);
+              }
+              ~SuspendCheckpoint() {
+                  mCheckpoint.setSuspended(false);
+              }
+          } suspendCheckpoint(mCheckpoint);
+
+          // fall back to perturbing in this process if workers can not be forked
+          bool useWorkers = aNumWorkers != 1 && !baseParams.empty();
+          std::string forkError;
+          if(useWorkers && !EnsembleRunner::canFork(forkError)) {
+              Interp::warning(forkError+"  Perturbing the parameters in this process instead.");
+              useWorkers = false;
+          }
+          if(!useWorkers) {
+              std::vector<double> outputValues;
+              outputValues.reserve(numOutputValues);
+              for(size_t param = 0; param < baseParams.size(); ++param) {
+                  bool success = false;
+                  try {
+                      success = runPerturbed(param, outputValues);
+                  }
+                  catch(...) {
+                      params.setValue(currScenario, param, baseParams[param]);
+                      try {
+                          restoreBase();
+                      }
+                      catch(...) {
+                          // report the original error
+                      }
+                      mCurrentPeriod = origPeriod;
+                      throw;
+                  }
+                  if(success) {
+                      recordColumn(param, outputValues.data());
+                  }
+                  else {
+                      Interp::warning("Perturbing parameter "+util::toString(param)+" failed: the model did not solve");
+                      recordColumn(param, 0);
+                  }
+                  params.setValue(currScenario, param, baseParams[param]);
+              }
+              // restore the base solution
+              if(!baseParams.empty()) {
+                  restoreBase();
+              }
+          }
+          else {
+              // each worker gets a copy of the model so nothing needs to be restored
+              // no other threads may be running when the workers are forked
+              mCheckpoint.wait();
+              EnsembleRunner ensemble(aNumWorkers);
+              try {
+                  ensemble.run(baseParams.size(),
+                    [&](const size_t aParam, std::string& aBuffer) {
+                      loggerFactoryWrapper.setCout(&std::cout);
+                      // the checkpoint belongs to the parent process
+                      mCheckpoint.disable();
+                      std::vector<double> outputValues;
+                      if(!runPerturbed(aParam, outputValues)) {
+                          throw std::runtime_error("the model did not solve");
+                      }
+                      aBuffer.append(reinterpret_cast<const char*>(outputValues.data()), outputValues.size() * sizeof(double));
+                    },
+                    [&](const size_t aParam, const bool aSuccess, const char* aData, const size_t aSize) {
+                      if(!aSuccess || aSize != numOutputValues * sizeof(double)) {
+                          const std::string error = aSuccess ? "unexpected number of outputs" : std::string(aData, aSize);
+                          Interp::warning("Perturbing parameter "+util::toString(aParam)+" failed: "+error);
+                          recordColumn(aParam, 0);
+                          return;
+                      }
+                      std::vector<double> outputValues(numOutputValues);
+                      memcpy(outputValues.data(), aData, aSize);
+                      recordColumn(aParam, outputValues.data());
+                    });
+              }
+              catch(...) {
+                  mCurrentPeriod = origPeriod;
+                  throw;
+              }
+          }
+          mCurrentPeriod = origPeriod;
+
+          Interp::List jacobianMats = Interp::createList(numOutputs);
+          for(int i = 0; i < numOutputs; ++i) {
+              Interp::setListAt(jacobianMats, i, Interp::wrapMatrix(jacobians[i], jacobians[i].size1(), jacobians[i].size2()));
+          }
+          Interp::List ret = Interp::createList(3);
+          Interp::setListAt(ret, 0, paramDF);
+          Interp::setListAt(ret, 1, outputDFs);
+          Interp::setListAt(ret, 2, jacobianMats);
+          return ret;
+      }
+
+      void setDeferClimate(const bool aDeferClimate) {
+          if(!isInitialized) {
+              Interp::stop("GCAM did not successfully initialize.");
+          }
+          if(aDeferClimate && !scenario->mModelFeedbacks.empty()) {
+              // we can not know if the feedbacks need the climate model so be safe
+              Interp::warning("The climate model will continue to run each period as model feedbacks may depend on it.");
+              return;
+          }
+          if(aDeferClimate && !isSingleScenarioRunner()) {
+              // periods would have to be run without the configured runner
+              Interp::warning("The climate model will continue to run each period as the configured scenario runner runs it.");
+              return;
+          }
+          if(!aDeferClimate) {
+              // catch up first so the climate model does not skip any periods
+              runClimateModel();
+          }
+          mDeferClimate = aDeferClimate;
+      }
+
+      void runClimateModel() {
+          if(!isInitialized) {
+              Interp::stop("GCAM did not successfully initialize.");
+          }
+          if(mIsMidPeriod) {
+              Interp::stop("Can not run the climate model while in the middle of running period "+util::toString(mCurrentPeriod));
+          }
+          markModelChanged();
+          if(mEarliestClimatePending == -1) {
+              // nothing to do
+              return;
+          }
+          // ensure Hector does not attempt to run past the last period which has been run
+          Configuration::getInstance()->intMap["stop-period"] = mLatestClimatePending;
+          for(int period = mEarliestClimatePending; period <= mLatestClimatePending; ++period) {
+              if(scenario->mIsValidPeriod[period]) {
+                  scenario->mWorld->runClimateModel(period);
+              }
+          }
+          mEarliestClimatePending = -1;
+          mLatestClimatePending = -1;
+      }
+
+      void loadPlugin(const std::string& aPath, const std::string& aOptions) {
+          if(mIsMidPeriod) {
+              Interp::stop("Can not load a plugin while in the middle of running period "+util::toString(mCurrentPeriod));
+          }
+          if(!isSingleScenarioRunner()) {
+              // periods would have to be run without the configured runner
+              Interp::stop("Plugins can only be used with the single scenario runner.");
+          }
+          mPlugins.load(aPath, aOptions);
+      }
+
+      void clearPlugins() {
+          if(mIsMidPeriod) {
+              Interp::stop("Can not unload plugins while in the middle of running period "+util::toString(mCurrentPeriod));
+          }
+          mPlugins.clear();
+      }
+
+      Interp::StringVector getPlugins() const {
+          return Interp::wrap(mPlugins.getNames());
+      }
+
+      void setCheckpointFile(const std::string& aFile) {
+          mCheckpoint.setFile(aFile);
+      }
+
+      int resumeFromCheckpoint(const std::string& aFile) {
+          if(!isInitialized) {
+              Interp::stop("GCAM did not successfully initialize.");
+          }
+          if(mIsMidPeriod) {
+              Interp::stop("Can not resume from a checkpoint while in the middle of running period "+util::toString(mCurrentPeriod));
+          }
+          PriceCheckpoint checkpoint;
+          checkpoint.read(aFile);
+          const int lastPeriod = checkpoint.getLastPeriod();
+          if(lastPeriod == -1) {
+              Interp::warning("Checkpoint file "+aFile+" does not contain any periods");
+          }
+          // run each period again starting the solver from the checkpointed prices
+          const string STOP_PERIOD_KEY = "stop-period";
+          Configuration* conf = Configuration::getInstance();
+          for(int period = 0; period <= lastPeriod; ++period) {
+              conf->intMap[STOP_PERIOD_KEY] = period;
+              runPeriodPre(period);
+              checkpoint.restore(period);
+              if(!runPeriodPost(period)) {
+                  Interp::warning("Failed to solve period "+util::toString(period));
+              }
+          }
+          return lastPeriod;
+      }
+
+      int getEarliestDirtyPeriod() const {
+          if(!isInitialized) {
+              Interp::stop("GCAM did not successfully initialize.");
+          }
+          return mEarliestDirtyPeriod;
+      }
+
+      void rerunFromEarliestDirty() {
+          if(!isInitialized) {
+              Interp::stop("GCAM did not successfully initialize.");
+          }
+          if(mIsMidPeriod) {
+              Interp::stop("Can not re-run model periods while in the middle of running period "+util::toString(mCurrentPeriod));
+          }
+          if(mEarliestDirtyPeriod == -1) {
+              // nothing to do
+              return;
+          }
+          invalidateDirtyPeriods();
+          runPeriod(mCurrentPeriod);
+      }
+
+      Interp::List runEnsemble(const Interp::List& aParamData, const Interp::DataFrame& aParamQueries, const int aNumMembers,
+                               const int aPeriod, const Interp::DataFrame& aQueries, const int aNumWorkers) {
+          if(!isInitialized) {
+              Interp::stop("GCAM did not successfully initialize.");
+          }
+          if(mIsMidPeriod) {
+              Interp::stop("Can not run an ensemble while in the middle of running period "+util::toString(mCurrentPeriod));
+          }
+          // sort out which data each member sets up front so the workers do
+          // not need to
+          std::vector<std::vector<int> > memberParams(std::max(aNumMembers, 0));
+          const int numParams = Interp::getListSize(aParamData);
+          if(numParams > 0) {
+              Interp::IntegerVector paramMembers(Interp::getDataFrameAt<Interp::IntegerVector>(aParamQueries, 0));
+              if(Interp::getDataFrameNumRows(aParamQueries) != numParams) {
+                  Interp::stop("Each ensemble member parameter must have a query.");
+              }
+              for(int param = 0; param < numParams; ++param) {
+                  if(paramMembers[param] < 0 || paramMembers[param] >= aNumMembers) {
+                      Interp::stop("Ensemble parameter for unknown member "+util::toString(paramMembers[param]));
+                  }
+                  memberParams[paramMembers[param]].push_back(param);
+              }
+          }
+          // parse the queries once here and the workers will inherit them
+          std::vector<std::unique_ptr<GetDataHelper> > helpers;
+          const int numQueries = Interp::getDataFrameNumRows(aQueries);
+          if(numQueries > 0) {
+              Interp::StringVector queries(Interp::getDataFrameAt<Interp::StringVector>(aQueries, 1));
+              for(int i = 0; i < numQueries; ++i) {
+                  helpers.emplace_back(new GetDataHelper(Interp::extract(queries[i])));
+              }
+          }
+
+          // no other threads may be running when the workers are forked
+          mCheckpoint.wait();
+          EnsembleRunner ensemble(aNumWorkers);
+          Interp::List ret = Interp::createList(std::max(aNumMembers, 0));
+          ensemble.run(std::max(aNumMembers, 0),
+            [&](const size_t aMember, std::string& aBuffer) {
+              // the interpreter and checkpoint belong to the parent process so
+              // keep the log out of it and do not overwrite the checkpoint
+              loggerFactoryWrapper.setCout(&std::cout);
+              mCheckpoint.disable();
+              if(!memberParams[aMember].empty()) {
+                  Interp::StringVector paramQueries(Interp::getDataFrameAt<Interp::StringVector>(aParamQueries, 1));
+                  for(int param : memberParams[aMember]) {
+                      setDataFast(Interp::getListAt<Interp::DataFrame>(aParamData, param), Interp::extract(paramQueries[param]));
+                  }
+              }
+              invalidateDirtyPeriods();
+              runPeriod(aPeriod);
+              SerializingResultWriter writer;
+              for(auto& helper : helpers) {
+                  helper->runExport(runner->getInternalScenario(), writer);
+                  writer.endTable();
+              }
+              aBuffer.append(writer.getBuffer());
+            },
+            [&](const size_t aMember, const bool aSuccess, const char* aData, const size_t aSize) {
+              if(!aSuccess) {
+                  const std::string error(aData, aSize);
+                  Interp::warning("Ensemble member "+util::toString(aMember)+" failed: "+error);
+                  Interp::setListAt(ret, aMember, error);
+                  return;
+              }
+              const char* end = aData + aSize;
+              Interp::List results = Interp::createList(helpers.size());
+              for(size_t i = 0; i < helpers.size(); ++i) {
+                  Interp::setListAt(results, i, SerializingResultWriter::readTable(aData, end));
+              }
+              Interp::setListAt(ret, aMember, results);
+            });
+          return ret;
       }
 
       SolutionDebugger createSolutionDebugger(const int aPeriod, const std::string& aMarketFilterStr) {
@@ -182,7 +787,47 @@ class gcam {
             Interp::warning("Solution debugger can only be created for current period "+util::toString(mCurrentPeriod)+" when running feedbacks.");
             period = mCurrentPeriod;
         }
-        return SolutionDebugger::createInstance(period, aMarketFilterStr);
+        return SolutionDebugger::createInstance(period, aMarketFilterStr, mGeneration);
+      }
+
+      bool refreshSolutionDebugger(SolutionDebugger& aDebugger) {
+          if(!isInitialized) {
+              Interp::stop("GCAM did not successfully initialize.");
+          }
+          // the state variables are reset each time a period is run so they
+          // must be set up again for the debugger's period as when it was created
+          const int period = aDebugger.getPeriod();
+          if(!mIsMidPeriod) {
+              delete scenario->mManageStateVars;
+              scenario->mManageStateVars = new ManageStateVariables(period);
+          } else if(period != mCurrentPeriod) {
+              Interp::stop("Solution debugger for period "+util::toString(period)+" can not be refreshed while running feedbacks for period "+
+                           util::toString(mCurrentPeriod)+", create a new one instead.");
+          }
+          return aDebugger.refresh();
+      }
+
+      bool solveMarkets(const int aPeriod, const std::string& aMarketFilterStr, const int aMaxIter, const double aTolerance) {
+          if(!isInitialized) {
+              Interp::stop("GCAM did not successfully initialize.");
+          }
+          // the debugger will adjust the period if needed in the same way
+          const int period = mIsMidPeriod ? mCurrentPeriod : aPeriod;
+          SolutionDebugger debugger = createSolutionDebugger(aPeriod, aMarketFilterStr);
+          auto start = std::chrono::steady_clock::now();
+          const double startCalcs = getCalcCount();
+          bool success = debugger.solve(aMaxIter, aTolerance);
+          std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+          mSolverTrace.record(period, "solve_markets", success, elapsed.count(), getCalcCount() - startCalcs);
+          // re-solving a period which has already been run does not update its
+          // post calc, climate, or feedbacks so that period and the ones after it
+          // are now out of date
+          if(!mIsMidPeriod && period <= mCurrentPeriod && scenario->mIsValidPeriod[period] &&
+             (mEarliestDirtyPeriod == -1 || period < mEarliestDirtyPeriod))
+          {
+              mEarliestDirtyPeriod = period;
+          }
+          return success;
       }
 
       int getCurrentPeriod() const {
@@ -236,6 +881,51 @@ class gcam {
               origXMLDBName;
       }
 
+      std::string printSelected(const Interp::DataFrame& aQueries, const std::string& aLocation, const std::string& aFormat) {
+          if(!isInitialized) {
+              Interp::stop("GCAM did not successfully initialize.");
+          }
+          const std::string location = !aLocation.empty() ? aLocation : scenario->getName();
+          const std::string ext = QueryResultWriter::getFileExtension(aFormat);
+          Interp::StringVector names(Interp::getDataFrameAt<Interp::StringVector>(aQueries, 0));
+          Interp::StringVector queries(Interp::getDataFrameAt<Interp::StringVector>(aQueries, 1));
+          const int numQueries = Interp::getDataFrameNumRows(aQueries);
+          for(int i = 0; i < numQueries; ++i) {
+              exportData(Interp::extract(queries[i]), location + "/" + Interp::extract(names[i]) + ext, aFormat, "");
+          }
+          return location;
+      }
+
+      Interp::DataFrame getSolverTrace() const {
+          return mSolverTrace.getDataFrame();
+      }
+
+      Interp::DataFrame getMarketStates(const std::string& aMarketFilter, const int aStartPeriod, const int aEndPeriod) const {
+          if(!isInitialized) {
+              Interp::stop("GCAM did not successfully initialize.");
+          }
+          // a negative period indicates to use the first / last model period
+          const int finalPeriod = scenario->getModeltime()->getmaxper() - 1;
+          const int startPeriod = aStartPeriod < 0 ? 0 : aStartPeriod;
+          const int endPeriod = aEndPeriod < 0 ? finalPeriod : std::min(aEndPeriod, finalPeriod);
+          if(startPeriod > endPeriod) {
+              Interp::stop("Invalid period range "+util::toString(startPeriod)+" to "+util::toString(endPeriod));
+          }
+          MarketStateCollector collector(aMarketFilter);
+          return collector.collect(scenario->getMarketplace(), startPeriod, endPeriod);
+      }
+
+      void setSolverTraceCapacity(const int aCapacity) {
+          if(aCapacity < 0) {
+              Interp::stop("Solver trace capacity must be non-negative.");
+          }
+          mSolverTrace.setCapacity(aCapacity);
+      }
+
+      void clearSolverTrace() {
+          mSolverTrace.clear();
+      }
+
       std::string getScenarioName() const {
           return scenario->getName();
       }
@@ -251,6 +941,222 @@ class gcam {
         bool mIsMidPeriod;
         LoggerFactoryWrapper loggerFactoryWrapper;
         unique_ptr<IScenarioRunner> runner;
+        //! The default number of solver attempts to keep in mSolverTrace
+        static const int DEFAULT_SOLVER_TRACE_CAPACITY = 1000;
+        //! A record of recent attempts to solve a model period
+        SolverTrace mSolverTrace;
+        //! The time spent in the last call to runPeriodPre, which is included
+        //! in the time recorded in mSolverTrace by runPeriodPost
+        std::chrono::steady_clock::duration mPrePeriodElapsed;
+        //! The number of model calculations in the last call to runPeriodPre
+        double mPrePeriodCalcs;
+        //! The earliest model period which has already been run but had data
+        //! changed by set data since, or -1 if no period is dirty
+        int mEarliestDirtyPeriod;
+        //! The queries used with getDataDelta, which keep the previous results
+        //! to compare against, by query string
+        std::map<std::string, std::unique_ptr<GetDataHelper> > mDeltaQueries;
+        //! If the climate model should not be run each period but rather when
+        //! runClimateModel is called
+        bool mDeferClimate;
+        //! The earliest model period which has been run without running the climate
+        //! model, or -1 if none
+        int mEarliestClimatePending;
+        //! The latest model period which has been run without running the climate
+        //! model, or -1 if none
+        int mLatestClimatePending;
+        //! Shared library plugins which are called as each period is run
+        PluginManager mPlugins;
+        //! The checkpoint of solved prices written as each period is run
+        PriceCheckpoint mCheckpoint;
+        //! The query string and value filter which identify a GetDataHelper
+        typedef std::pair<std::string, std::string> GetDataKey;
+        //! The maximum number of parsed queries to keep in mGetDataQueries
+        static const size_t MAX_CACHED_QUERIES = 64;
+        //! The largest number of rows each helper in mGetDataQueries may keep
+        //! memory allocated for
+        static const size_t MAX_CACHED_QUERY_ROWS = 4096;
+        //! Parsed queries available to be reused by get data calls so that
+        //! calling the same queries every period does not need to parse them
+        //! or allocate memory for the results again
+        std::map<GetDataKey, std::unique_ptr<GetDataHelper> > mGetDataQueries;
+
+        /*!
+         * \brief Take the GetDataHelper for the given query out of the cache, or
+         *        parse a new one if it is not available.
+         * \details The helper is removed from the cache while it is in use so that
+         *          if the same query is run again, say from a get_data_chunked callback,
+         *          it will not clobber the results in progress.  If the query raises an
+         *          error the helper is simply not returned to the cache.
+         * \param aKey The query string and value filter.
+         * \return A GetDataHelper ready to run the query.
+         */
+        std::unique_ptr<GetDataHelper> acquireGetDataHelper(const GetDataKey& aKey) {
+            auto iter = mGetDataQueries.find(aKey);
+            if(iter == mGetDataQueries.end() || !(*iter).second) {
+                return std::unique_ptr<GetDataHelper>(new GetDataHelper(aKey.first, aKey.second));
+            }
+            std::unique_ptr<GetDataHelper> ret = std::move((*iter).second);
+            mGetDataQueries.erase(iter);
+            return ret;
+        }
+
+        /*!
+         * \brief Return a GetDataHelper to the cache once it is done running.
+         * \details If the cache is full it is simply emptied as it would be unusual
+         *          to cycle through so many distinct queries.  The results the
+         *          helper recorded have already been handed off so they are dropped
+         *          and only small buffers are kept for reuse.
+         * \param aKey The query string and value filter.
+         * \param aHelper The helper previously given by acquireGetDataHelper.
+         */
+        void releaseGetDataHelper(const GetDataKey& aKey, std::unique_ptr<GetDataHelper>&& aHelper) {
+            aHelper->releaseData(MAX_CACHED_QUERY_ROWS);
+            if(mGetDataQueries.size() >= MAX_CACHED_QUERIES) {
+                mGetDataQueries.clear();
+            }
+            mGetDataQueries[aKey] = std::move(aHelper);
+        }
+
+        //! Identifies a cached query result by the query with surrounding whitespace
+        //! removed, the value filter, and if the results are wide
+        typedef std::tuple<std::string, std::string, bool> QueryResultKey;
+        //! The maximum number of results to keep in mQueryResults
+        static const size_t MAX_CACHED_RESULTS = 32;
+        //! A counter which is incremented each time the model may have changed, it
+        //! is shared with solution debuggers which may also change the model
+        std::shared_ptr<unsigned long> mGeneration;
+        //! The value of mGeneration when the results in mQueryResults were found
+        unsigned long mQueryResultsGeneration;
+        //! Results of get data calls which can be given again for the same query
+        //! as long as the model has not changed
+        std::map<QueryResultKey, Interp::DataFrame> mQueryResults;
+
+        /*!
+         * \brief Note the model may have changed so that any cached query results
+         *        will not be used again.
+         */
+        void markModelChanged() {
+            ++(*mGeneration);
+        }
+
+        /*!
+         * \brief Find the cached results of a query if the model has not changed
+         *        since they were found.
+         * \param aKey The query to find.
+         * \return The cached results or null if not available.
+         */
+        const Interp::DataFrame* findQueryResult(const QueryResultKey& aKey) {
+            if(mQueryResultsGeneration != *mGeneration) {
+                mQueryResults.clear();
+                mQueryResultsGeneration = *mGeneration;
+                return 0;
+            }
+            auto iter = mQueryResults.find(aKey);
+            return iter != mQueryResults.end() ? &(*iter).second : 0;
+        }
+
+        /*!
+         * \brief Cache the results of a query.
+         * \details If the cache is full it is simply emptied as it would be unusual
+         *          to cycle through so many distinct queries between model changes.
+         * \param aKey The query which was run.
+         * \param aResult The results of the query.
+         */
+        void addQueryResult(const QueryResultKey& aKey, const Interp::DataFrame& aResult) {
+            if(mQueryResultsGeneration != *mGeneration || mQueryResults.size() >= MAX_CACHED_RESULTS) {
+                mQueryResults.clear();
+                mQueryResultsGeneration = *mGeneration;
+            }
+            mQueryResults.insert(std::make_pair(aKey, aResult));
+        }
+
+        /*!
+         * \brief Invalidate the dirty periods, if any, so that they will get run again.
+         */
+        void invalidateDirtyPeriods() {
+            if(mEarliestDirtyPeriod == -1) {
+                return;
+            }
+            for(size_t period = mEarliestDirtyPeriod; period < scenario->mIsValidPeriod.size(); ++period) {
+                scenario->mIsValidPeriod[period] = false;
+            }
+            mEarliestDirtyPeriod = -1;
+        }
+
+        /*!
+         * \brief Update the earliest dirty period given the earliest year that was
+         *        just set by a set data call.
+         * \details Data set in periods which have not been run yet, including the current
+         *          period if we are in between run_period_pre and run_period_post, do not
+         *          make the model dirty.
+         * \param aEarliestSetYear The earliest year set as reported by QueryProcessorBase.
+         */
+        void updateDirtyPeriod(const int aEarliestSetYear) {
+            if(aEarliestSetYear == QueryProcessorBase::NO_DATA_SET) {
+                return;
+            }
+            int period = aEarliestSetYear == QueryProcessorBase::ALL_YEARS_SET ? 0 :
+                scenario->getModeltime()->getyr_to_per(aEarliestSetYear);
+            int lastRunPeriod = mIsMidPeriod ? mCurrentPeriod - 1 : mCurrentPeriod;
+            if(period > lastRunPeriod || !scenario->mIsValidPeriod[period]) {
+                return;
+            }
+            if(mEarliestDirtyPeriod == -1 || period < mEarliestDirtyPeriod) {
+                mEarliestDirtyPeriod = period;
+            }
+        }
+
+        /*!
+         * \brief The total number of times the model has been calculated.
+         * \return The count from the world's calc counter.
+         */
+        double getCalcCount() const {
+            return scenario->mWorld->getCalcCounter()->getTotalCount();
+        }
+
+        /*!
+         * \brief If the configured scenario runner simply runs the scenario.
+         * \details Other runners, such as for a policy target, run the scenario
+         *          many times and so can not be replaced by running the period
+         *          ourselves.
+         * \return If the runner is a SingleScenarioRunner.
+         */
+        bool isSingleScenarioRunner() const {
+            return dynamic_cast<SingleScenarioRunner*>(runner.get()) != 0;
+        }
+
+        /*!
+         * \brief Run the scenario runner up to aPeriod and record the attempt
+         *        in the solver trace.
+         * \param aPeriod The model period to run.
+         * \param aTimer The timer to pass along to the scenario runner.
+         * \return If the period solved successfully.
+         */
+        bool runScenariosTraced(const int aPeriod, Timer& aTimer) {
+            if(mDeferClimate || !mPlugins.empty()) {
+                // the scenario runner always runs the climate model and does not
+                // know about plugins so we run the period ourselves, runPeriodPost
+                // will record the solver trace, note this is only allowed with the
+                // single scenario runner which does nothing more
+                runPeriodPre(aPeriod);
+                const bool success = runPeriodPost(aPeriod);
+                if(!success) {
+                    Interp::warning("Failed to solve period "+util::toString(aPeriod));
+                }
+                return success;
+            }
+            auto start = std::chrono::steady_clock::now();
+            const double startCalcs = getCalcCount();
+            bool success = runner->runScenarios(aPeriod, false, aTimer);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            mSolverTrace.record(aPeriod, "run_period", success, elapsed.count(), getCalcCount() - startCalcs);
+            mCheckpoint.record(aPeriod);
+            if(!success) {
+                Interp::warning("Failed to solve period "+util::toString(aPeriod));
+            }
+            return success;
+        }
         void initializeScenario(string configurationArg) {
             string loggerFactoryArg = "log_conf.xml";
 
@@ -334,14 +1240,41 @@ RCPP_MODULE(gcam_module) {
         .method("run_period_post",        &gcam::runPeriodPost,         "run to model period solve and post")
         .method("set_data", &gcam::setData, "set data")
         .method("get_data", &gcam::getData, "get data")
+        .method("get_data_wide", &gcam::getDataWide, "get data with years as columns")
+        .method("get_data_chunked", &gcam::getDataChunked, "get data in chunks")
+        .method("export_data", &gcam::exportData, "write query results directly to a file")
+        .method("get_export_file_extension", &gcam::getExportFileExtension, "get the file extension used when exporting in a format")
+        .method("get_data_delta", &gcam::getDataDelta, "get only the data which changed since the last call")
+        .method("reset_data_delta", &gcam::resetDataDelta, "forget the previous results used by get data delta")
         .method("set_data_fast", &gcam::setDataFast, "set data_fast")
+        .method("profile_get_data", &gcam::profileGetData, "run get data reporting the work done by each filter step")
+        .method("profile_set_data", &gcam::profileSetData, "run set data reporting the work done by each filter step")
+        .method("dry_run", &gcam::dryRun, "count the rows a get data query would find without recording them")
         .method("create_solution_debugger", &gcam::createSolutionDebugger, "create solution debugger")
+        .method("refresh_solution_debugger", &gcam::refreshSolutionDebugger, "update a solution debugger from the current state of the model")
+        .method("solve_markets", &gcam::solveMarkets, "solve a subset of markets holding others fixed")
         .method("get_current_period", &gcam::getCurrentPeriod, "get the last run model period")
         .method("convert_period_to_year", &gcam::convertPeriodToYear, "convert a GCAM model period to year")
         .method("convert_year_to_period", &gcam::convertYearToPeriod, "convert a GCAM model year to model period")
         .method("print_xmldb", &gcam::printXMLDB, "write the full XML Database results")
+        .method("print_selected", &gcam::printSelected, "write only the results of the given queries")
         .method("set_scenario_name", &gcam::setScenarioName, "set scenario name")
         .method("get_scenario_name", &gcam::getScenarioName, "get scenario name")
+        .method("get_earliest_dirty_period", &gcam::getEarliestDirtyPeriod, "get the earliest model period invalidated by set data")
+        .method("rerun_from_earliest_dirty", &gcam::rerunFromEarliestDirty, "re-run the model from the earliest dirty period")
+        .method("get_solver_trace", &gcam::getSolverTrace, "get the recent solver attempts")
+        .method("get_market_states", &gcam::getMarketStates, "get the price, supply, and demand of markets")
+        .method("set_solver_trace_capacity", &gcam::setSolverTraceCapacity, "set the number of solver attempts to keep")
+        .method("clear_solver_trace", &gcam::clearSolverTrace, "clear the recorded solver attempts")
+        .method("run_ensemble", &gcam::runEnsemble, "run ensemble members in forked worker processes")
+        .method("sensitivity", &gcam::sensitivity, "calculate the sensitivity of outputs to parameters by finite differences")
+        .method("set_defer_climate", &gcam::setDeferClimate, "set if the climate model should only be run on demand")
+        .method("run_climate_model", &gcam::runClimateModel, "run the climate model for any periods it was deferred")
+        .method("load_plugin", &gcam::loadPlugin, "load a shared library plugin to call as periods are run")
+        .method("clear_plugins", &gcam::clearPlugins, "unload all plugins")
+        .method("get_plugins", &gcam::getPlugins, "get the names of the loaded plugins")
+        .method("set_checkpoint_file", &gcam::setCheckpointFile, "set the file to checkpoint prices to as periods are run")
+        .method("resume_from_checkpoint", &gcam::resumeFromCheckpoint, "run periods again from checkpointed prices")
         ;
 
   Rcpp::class_<SolutionDebugger>("SolutionDebugger")
@@ -356,6 +1289,7 @@ RCPP_MODULE(gcam_module) {
   .method("evaluate", &SolutionDebugger::evaluate, "evaluate")
   .method("evaluate_partial", &SolutionDebugger::evaluatePartial, "evaluatePartial")
   .method("calc_derivative", &SolutionDebugger::calcDerivative, "calcDerivative")
+  .method("calc_newton_diagnostics", &SolutionDebugger::calcNewtonDiagnostics, "calcNewtonDiagnostics")
   .method("get_slope", &SolutionDebugger::getSlope, "getSlope")
   .method("set_slope", &SolutionDebugger::setSlope, "setSlope")
   .method("reset_scales", &SolutionDebugger::resetScales, "resetScales")
@@ -373,14 +1307,41 @@ BOOST_PYTHON_MODULE(gcam_module) {
         .def("run_period_post",        &gcam::runPeriodPost,         "run to model period solve and post")
         .def("set_data", &gcam::setData, "set data")
         .def("get_data", &gcam::getData, "get data")
+        .def("get_data_wide", &gcam::getDataWide, "get data with years as columns")
+        .def("get_data_chunked", &gcam::getDataChunked, "get data in chunks")
+        .def("export_data", &gcam::exportData, "write query results directly to a file")
+        .def("get_export_file_extension", &gcam::getExportFileExtension, "get the file extension used when exporting in a format")
+        .def("get_data_delta", &gcam::getDataDelta, "get only the data which changed since the last call")
+        .def("reset_data_delta", &gcam::resetDataDelta, "forget the previous results used by get data delta")
         .def("set_data_fast", &gcam::setDataFast, "set data_fast")
+        .def("profile_get_data", &gcam::profileGetData, "run get data reporting the work done by each filter step")
+        .def("profile_set_data", &gcam::profileSetData, "run set data reporting the work done by each filter step")
+        .def("dry_run", &gcam::dryRun, "count the rows a get data query would find without recording them")
         .def("create_solution_debugger", &gcam::createSolutionDebugger, "create solution debugger")
+        .def("refresh_solution_debugger", &gcam::refreshSolutionDebugger, "update a solution debugger from the current state of the model")
+        .def("solve_markets", &gcam::solveMarkets, "solve a subset of markets holding others fixed")
         .def("get_current_period", &gcam::getCurrentPeriod, "get the last run model period")
         .def("convert_period_to_year", &gcam::convertPeriodToYear, "convert a GCAM model period to year")
         .def("convert_year_to_period", &gcam::convertYearToPeriod, "convert a GCAM model year to model period")
         .def("print_xmldb", &gcam::printXMLDB, "write the full XML Database results")
+        .def("print_selected", &gcam::printSelected, "write only the results of the given queries")
         .def("set_scenario_name", &gcam::setScenarioName, "set scenario name")
         .def("get_scenario_name", &gcam::getScenarioName, "get scenario name")
+        .def("get_earliest_dirty_period", &gcam::getEarliestDirtyPeriod, "get the earliest model period invalidated by set data")
+        .def("rerun_from_earliest_dirty", &gcam::rerunFromEarliestDirty, "re-run the model from the earliest dirty period")
+        .def("get_solver_trace", &gcam::getSolverTrace, "get the recent solver attempts")
+        .def("get_market_states", &gcam::getMarketStates, "get the price, supply, and demand of markets")
+        .def("set_solver_trace_capacity", &gcam::setSolverTraceCapacity, "set the number of solver attempts to keep")
+        .def("clear_solver_trace", &gcam::clearSolverTrace, "clear the recorded solver attempts")
+        .def("run_ensemble", &gcam::runEnsemble, "run ensemble members in forked worker processes")
+        .def("sensitivity", &gcam::sensitivity, "calculate the sensitivity of outputs to parameters by finite differences")
+        .def("set_defer_climate", &gcam::setDeferClimate, "set if the climate model should only be run on demand")
+        .def("run_climate_model", &gcam::runClimateModel, "run the climate model for any periods it was deferred")
+        .def("load_plugin", &gcam::loadPlugin, "load a shared library plugin to call as periods are run")
+        .def("clear_plugins", &gcam::clearPlugins, "unload all plugins")
+        .def("get_plugins", &gcam::getPlugins, "get the names of the loaded plugins")
+        .def("set_checkpoint_file", &gcam::setCheckpointFile, "set the file to checkpoint prices to as periods are run")
+        .def("resume_from_checkpoint", &gcam::resumeFromCheckpoint, "run periods again from checkpointed prices")
         ;
     to_python_converter<Interp::NumericVector, Interp::vec_to_python<Interp::NumericVector> >();
     to_python_converter<Interp::StringVector, Interp::vec_to_python<Interp::StringVector> >();
@@ -398,6 +1359,7 @@ BOOST_PYTHON_MODULE(gcam_module) {
   .def("evaluate", &SolutionDebugger::evaluate_wrap, "evaluate")
   .def("evaluate_partial", &SolutionDebugger::evaluatePartial, "evaluatePartial")
   .def("calc_derivative", &SolutionDebugger::calcDerivative, "calcDerivative")
+  .def("calc_newton_diagnostics", &SolutionDebugger::calcNewtonDiagnostics, "calcNewtonDiagnostics")
   .def("get_slope", &SolutionDebugger::getSlope, "getSlope")
   .def("set_slope", &SolutionDebugger::setSlope_wrap, "setSlope")
   .def("reset_scales", &SolutionDebugger::resetScales, "resetScales")
@@ -1,13 +1,38 @@
 #include "interp_interface.h"
 
 #include "get_data_helper.h"
+#include "query_result_writer.h"
 
 #include "util/base/include/gcam_fusion.hpp"
 #include "util/base/include/gcam_data_containers.h"
 
+#include "year_range.h"
+
+#include <cmath>
+#include <limits>
+#include <chrono>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
 using namespace std;
 using namespace Interp;
 
+/*!
+ * \brief Clear the given vector and give back its memory if it could hold more
+ *        than aMaxRetainedRows.
+ * \param aVector The vector to release.
+ * \param aMaxRetainedRows The largest capacity to keep for reuse.
+ */
+template<typename VecType>
+void releaseVector(VecType& aVector, const size_t aMaxRetainedRows) {
+    if(aVector.capacity() > aMaxRetainedRows) {
+        VecType().swap(aVector);
+    }
+    else {
+        aVector.clear();
+    }
+}
+
 /*!
  * \brief A wrapper around an AMatchesValue so that we can record to a DataFrame
  *        the current values that may be matched by AMatchesValue.
@@ -23,8 +48,17 @@ public:
     const std::string getDataName() const {
         return mDataName;
     }
+    virtual bool isExactMatch() const {
+        return mToWrap->isExactMatch();
+    }
     virtual void recordPath() {};
+    virtual int internCurrent() { return 0; };
+    virtual void recordInterned(const int aID) {};
+    virtual void recordMissing() {};
     virtual void updateDataFrame(DataFrame& aDataFrame) const {};
+    virtual void writeColumn(QueryResultWriter& aWriter) const {};
+    virtual void clearData() {};
+    virtual void releaseData(const size_t aMaxRetainedRows) {};
 
 protected:
     //! The actual AMatchesValue which determines if the current path matches the query
@@ -48,13 +82,41 @@ public:
     virtual void recordPath() {
         mData.push_back(mCurrValue);
     }
+    virtual int internCurrent() {
+        auto iter = mInternIDs.find(mCurrValue);
+        if(iter == mInternIDs.end()) {
+            iter = mInternIDs.emplace(mCurrValue, mInterned.size()).first;
+            mInterned.push_back(mCurrValue);
+        }
+        return (*iter).second;
+    }
+    virtual void recordInterned(const int aID) {
+        mData.push_back(mInterned[aID]);
+    }
+    virtual void recordMissing() {
+        // a string column has no missing value so leave it empty
+        mData.push_back(string());
+    }
     virtual void updateDataFrame(DataFrame& aDataFrame) const {
         aDataFrame[mDataName] = Interp::wrap(mData);
     }
+    virtual void writeColumn(QueryResultWriter& aWriter) const {
+        aWriter.addColumn(mDataName, mData);
+    }
+    virtual void clearData() {
+        mData.clear();
+    }
+    virtual void releaseData(const size_t aMaxRetainedRows) {
+        releaseVector(mData, aMaxRetainedRows);
+    }
     private:
     //! A temporary holding the last matched value which may get copied
     //! into mData if recordPath is called
     string mCurrValue;
+    //! Each distinct value seen by internCurrent indexed by ID
+    vector<string> mInterned;
+    //! The reverse lookup of mInterned
+    unordered_map<string, int> mInternIDs;
     //! The list of values that matched when a query successfully found data
     //! which can be transformed into a column of a DataFrame
     //TODO: probably better as a std::list
@@ -76,8 +138,41 @@ public:
     virtual void recordPath() {
         mData.push_back(mCurrValue);
     }
+    virtual int internCurrent() {
+        // an int is already its own ID
+        return mCurrValue;
+    }
+    virtual void recordInterned(const int aID) {
+        mData.push_back(aID);
+    }
+    virtual void recordMissing() {
+        mMissingRows.push_back(mData.size());
+        mData.push_back(0);
+    }
     virtual void updateDataFrame(DataFrame& aDataFrame) const {
-        aDataFrame[mDataName] = Interp::wrap(mData);
+        if(mMissingRows.empty()) {
+            aDataFrame[mDataName] = Interp::wrap(mData);
+        }
+        else {
+            // an int column can not hold a missing value so fall back to
+            // a real column with NaN
+            vector<double> withMissing(mData.begin(), mData.end());
+            for(auto row : mMissingRows) {
+                withMissing[row] = std::numeric_limits<double>::quiet_NaN();
+            }
+            aDataFrame[mDataName] = Interp::wrap(withMissing);
+        }
+    }
+    virtual void writeColumn(QueryResultWriter& aWriter) const {
+        aWriter.addColumn(mDataName, mData);
+    }
+    virtual void clearData() {
+        mData.clear();
+        mMissingRows.clear();
+    }
+    virtual void releaseData(const size_t aMaxRetainedRows) {
+        releaseVector(mData, aMaxRetainedRows);
+        releaseVector(mMissingRows, aMaxRetainedRows);
     }
     private:
     //! A temporary holding the last matched value which may get copied
@@ -87,14 +182,117 @@ public:
     //! which can be transformed into a column of a DataFrame
     //TODO: probably better as a std::list
     vector<int> mData;
+    //! The rows in mData which have no value
+    vector<size_t> mMissingRows;
+};
+
+/*!
+ * \brief A predicate on the values found by a query.
+ * \details The filter string is one or more conditions separated by `,` all of
+ *          which must be true for a value to be kept.  The conditions are:
+ *          `nonzero` to drop zero and NaN values, `finite` to drop NaN and infinite
+ *          values, or a comparison operator (`>`, `>=`, `<`, `<=`, `==`, `!=`)
+ *          followed by a number such as `> 1e-6`.
+ */
+class ValueFilter {
+public:
+    ValueFilter(const std::string& aFilterStr) {
+        std::vector<std::string> conditions;
+        boost::split(conditions, aFilterStr, boost::is_any_of(","));
+        for(auto condition : conditions) {
+            boost::trim(condition);
+            if(condition == "nonzero") {
+                mConditions.emplace_back(NONZERO, 0.0);
+            }
+            else if(condition == "finite") {
+                mConditions.emplace_back(FINITE, 0.0);
+            }
+            else {
+                // the operator is everything up to the number
+                const size_t opEnd = std::min(condition.find_first_not_of("<>=!"), condition.size());
+                const std::string op = condition.substr(0, opEnd);
+                Operator parsedOp = EQ;
+                if(op == ">") {
+                    parsedOp = GT;
+                }
+                else if(op == ">=") {
+                    parsedOp = GTE;
+                }
+                else if(op == "<") {
+                    parsedOp = LT;
+                }
+                else if(op == "<=") {
+                    parsedOp = LTE;
+                }
+                else if(op == "==") {
+                    parsedOp = EQ;
+                }
+                else if(op == "!=") {
+                    parsedOp = NEQ;
+                }
+                else {
+                    Interp::stop("Unknown value filter: "+condition);
+                }
+                try {
+                    mConditions.emplace_back(parsedOp, boost::lexical_cast<double>(boost::trim_copy(condition.substr(opEnd))));
+                }
+                catch(const boost::bad_lexical_cast&) {
+                    Interp::stop("Could not parse the number in value filter: "+condition);
+                }
+            }
+        }
+    }
+    bool matches(const double aValue) const {
+        for(const auto& condition : mConditions) {
+            bool keep = false;
+            switch(condition.first) {
+                case NONZERO: keep = aValue != 0.0 && !std::isnan(aValue); break;
+                case FINITE: keep = std::isfinite(aValue); break;
+                case GT: keep = aValue > condition.second; break;
+                case GTE: keep = aValue >= condition.second; break;
+                case LT: keep = aValue < condition.second; break;
+                case LTE: keep = aValue <= condition.second; break;
+                case EQ: keep = aValue == condition.second; break;
+                case NEQ: keep = aValue != condition.second; break;
+            }
+            if(!keep) {
+                return false;
+            }
+        }
+        return true;
+    }
+private:
+    enum Operator {
+        NONZERO,
+        FINITE,
+        GT,
+        GTE,
+        LT,
+        LTE,
+        EQ,
+        NEQ
+    };
+    //! The conditions to check, the second value is the threshold if needed
+    std::vector<std::pair<Operator, double> > mConditions;
 };
 
 /*!
  * \brief Prepare to run the given query.
  * \param aQuery The GCAM Fusion query to be parsed
+ * \param aValueFilter An optional filter on the values found, see ValueFilter,
+ *                     where values which do not pass are dropped before they are
+ *                     recorded or an empty string to keep all values.
+ * \param aProfile If the work done by each filter step should be recorded,
+ *                 see runProfile.
  */
-GetDataHelper::GetDataHelper(const std::string& aQuery):QueryProcessorBase() {
-    // parse the query into filter steps
+GetDataHelper::GetDataHelper(const std::string& aQuery, const std::string& aValueFilter, const bool aProfile):QueryProcessorBase(), mChunkSize(0), mChunkCallback(0),
+    mValueFilter(boost::trim_copy(aValueFilter).empty() ? 0 : new ValueFilter(aValueFilter)), mIsDelta(false),
+    mIsWide(false), mIsCount(false), mCountAnyType(false), mNumCounted(0), mWideYear(NO_WIDE_YEAR), mIsNewWideRow(false), mNumWideRows(0)
+{
+    // parse the query into filter steps, a year filter on the data itself
+    // will be applied in vectorDataHelper so we only visit the years needed
+    mPushDownYearRange = true;
+    mProfile = aProfile;
     parseFilterString(aQuery);
 
     // determine if a user already filtered a period vector of data
@@ -108,6 +306,10 @@ GetDataHelper::GetDataHelper(const std::string& aQuery):QueryProcessorBase() {
     }
 }
 
+GetDataHelper::~GetDataHelper() {
+    delete mValueFilter;
+}
+
 /*!
  * \brief Run the query against the given Scenario context and
  *        return the results as a DataFrame.
@@ -119,11 +321,237 @@ GetDataHelper::GetDataHelper(const std::string& aQuery):QueryProcessorBase() {
  *         from the query.
  */
 DataFrame GetDataHelper::run(Scenario* aScenario) {
+  // discard anything left over from a previous run, the buffers may keep some
+  // capacity so a helper which is reused will not need to grow them again
+  clearData();
   // run the query, the specialized filters will keep track
   // of matching data to use as columns as it processes
   GCAMFusion<GetDataHelper> fusion(*this, mFilterSteps);
   fusion.startFilter(aScenario);
 
+  return createDataFrame();
+}
+
+/*!
+ * \brief Run the query against the given Scenario context handing off
+ *        the results in chunks as the query proceeds.
+ * \details Each time aChunkSize rows have been found they are organized into
+ *          a DataFrame, passed to aCallback, and then cleared so that the memory
+ *          required stays bounded.  Any remaining rows are passed along once the
+ *          query completes.
+ * \param aScenario The Scenario object which will serve as the
+ *                  query context from which to evaluate the query.
+ * \param aChunkSize The number of rows to include in each chunk.
+ * \param aCallback The interpreter function to call with each chunk.
+ */
+void GetDataHelper::runChunked(Scenario* aScenario, const size_t aChunkSize, const Interp::Function& aCallback) {
+  if(aChunkSize == 0) {
+      Interp::stop("The chunk size must be greater than zero.");
+  }
+  clearData();
+  mChunkSize = aChunkSize;
+  mChunkCallback = &aCallback;
+  mDataVector.reserve(aChunkSize);
+
+  GCAMFusion<GetDataHelper> fusion(*this, mFilterSteps);
+  fusion.startFilter(aScenario);
+
+  if(!mDataVector.empty()) {
+      aCallback(createDataFrame());
+      clearData();
+  }
+  mChunkSize = 0;
+  mChunkCallback = 0;
+}
+
+/*!
+ * \brief Run the query against the given Scenario context and report where
+ *        the time was spent rather than the results.
+ * \details This helper must have been created with aProfile set so that the
+ *          work done by each filter step is recorded.  The results are organized
+ *          into a DataFrame as run would so that cost is included but then
+ *          discarded.
+ * \param aScenario The Scenario object which will serve as the
+ *                  query context from which to evaluate the query.
+ * \param aSetupTime The time it took to create this helper, to include in the
+ *                   report.
+ * \return The profile as given by createProfile.
+ */
+Interp::List GetDataHelper::runProfile(Scenario* aScenario, const double aSetupTime) {
+  if(!mProfile) {
+      Interp::stop("The query was not parsed to be profiled.");
+  }
+  clearData();
+  auto start = std::chrono::steady_clock::now();
+  GCAMFusion<GetDataHelper> fusion(*this, mFilterSteps);
+  fusion.startFilter(aScenario);
+  auto traversed = std::chrono::steady_clock::now();
+  DataFrame results = createDataFrame();
+  auto converted = std::chrono::steady_clock::now();
+
+  return createProfile(aSetupTime,
+                       std::chrono::duration<double>(traversed - start).count(),
+                       std::chrono::duration<double>(converted - traversed).count(),
+                       mDataVector.size());
+}
+
+/*!
+ * \brief Run the query against the given Scenario context only counting the
+ *        values found.
+ * \details No path values are recorded and no results are allocated so this
+ *          is a cheap way to find out how many rows run would give, before they
+ *          are aggregated.
+ * \param aScenario The Scenario object which will serve as the
+ *                  query context from which to evaluate the query.
+ * \param aCountAnyType If set, data of a type which could not be recorded,
+ *                      such as a CONTAINER, counts once rather than being an
+ *                      error.  This allows checking if a partial query reaches
+ *                      anything.
+ * \return The number of values found which pass the value filter, if any.
+ */
+size_t GetDataHelper::runCount(Scenario* aScenario, const bool aCountAnyType) {
+  clearData();
+  mIsCount = true;
+  mCountAnyType = aCountAnyType;
+  mNumCounted = 0;
+  GCAMFusion<GetDataHelper> fusion(*this, mFilterSteps);
+  fusion.startFilter(aScenario);
+  mIsCount = false;
+  mCountAnyType = false;
+  return mNumCounted;
+}
+
+/*!
+ * \brief Run the query against the given Scenario context and pass the
+ *        results as columns to aWriter.
+ * \details The columns are handed off directly from the buffers recorded here
+ *          so the results never need to be converted to interpreter objects.
+ *          The writer only references the data so this GetDataHelper must still
+ *          be alive when the writer writes the file.
+ * \param aScenario The Scenario object which will serve as the
+ *                  query context from which to evaluate the query.
+ * \param aWriter The writer which will receive the path columns followed by
+ *                the value column.
+ */
+void GetDataHelper::runExport(Scenario* aScenario, QueryResultWriter& aWriter) {
+  clearData();
+  GCAMFusion<GetDataHelper> fusion(*this, mFilterSteps);
+  fusion.startFilter(aScenario);
+
+  for(auto path : mPathTracker) {
+      path->writeColumn(aWriter);
+  }
+  aWriter.addColumn(mDataColName, mDataVector);
+}
+
+/*!
+ * \brief Run the query against the given Scenario context and return only
+ *        the results which have changed since the last call to runDelta.
+ * \details Unlike run, the values are aggregated by the recorded path columns
+ *          as the query runs so they can be compared to the previous results.
+ *          Any paths which were found previously but no longer are reported with
+ *          a NaN value.  The first call reports all results.
+ * \param aScenario The Scenario object which will serve as the
+ *                  query context from which to evaluate the query.
+ * \param aTolerance Values which changed by no more than this absolute amount
+ *                   are not reported.
+ * \return A DataFrame of the new or changed rows in the same format as run.
+ */
+DataFrame GetDataHelper::runDelta(Scenario* aScenario, const double aTolerance) {
+  mIsDelta = true;
+  mDeltaCurr.clear();
+  mDeltaCurr.reserve(mDeltaPrev.size());
+  GCAMFusion<GetDataHelper> fusion(*this, mFilterSteps);
+  fusion.startFilter(aScenario);
+  mIsDelta = false;
+
+  clearData();
+  for(const auto& curr : mDeltaCurr) {
+      auto prevIter = mDeltaPrev.find(curr.first);
+      if(prevIter == mDeltaPrev.end()) {
+          recordRow(curr.first, curr.second);
+      }
+      else {
+          const double prevValue = (*prevIter).second;
+          const bool bothNaN = std::isnan(curr.second) && std::isnan(prevValue);
+          if(!bothNaN && !(std::abs(curr.second - prevValue) <= aTolerance)) {
+              recordRow(curr.first, curr.second);
+          }
+          mDeltaPrev.erase(prevIter);
+      }
+  }
+  // anything left over was removed
+  for(const auto& removed : mDeltaPrev) {
+      recordRow(removed.first, std::numeric_limits<double>::quiet_NaN());
+  }
+  mDeltaPrev.swap(mDeltaCurr);
+
+  DataFrame ret = createDataFrame();
+  clearData();
+  return ret;
+}
+
+/*!
+ * \brief Run the query against the given Scenario context and return the
+ *        results in a wide format with years as columns.
+ * \details Each vector of data found becomes a single row so the path columns
+ *          are not repeated for every year.  The year column is replaced by a
+ *          value column for each year found, named by the year, where a row
+ *          has NaN for any years which were not in that vector or were filtered.
+ *          Note the results are not aggregated.  An error is raised if the query
+ *          finds data which is not a vector by year.
+ * \param aScenario The Scenario object which will serve as the
+ *                  query context from which to evaluate the query.
+ * \return A DataFrame with the path columns followed by a column per year.
+ */
+DataFrame GetDataHelper::runWide(Scenario* aScenario) {
+  clearData();
+  mIsWide = true;
+  GCAMFusion<GetDataHelper> fusion(*this, mFilterSteps);
+  fusion.startFilter(aScenario);
+  mIsWide = false;
+
+  DataFrame ret = Interp::createDataFrame();
+  // the year tracker, if any, is always the last and will not have recorded anything
+  const size_t numPathCols = mHasYearInPath && mPathTracker.back()->getDataName() == "year" ?
+    mPathTracker.size() - 1 : mPathTracker.size();
+  for(size_t i = 0; i < numPathCols; ++i) {
+      mPathTracker[i]->updateDataFrame(ret);
+  }
+  for(auto& yearCol : mWideData) {
+      yearCol.second.resize(mNumWideRows, std::numeric_limits<double>::quiet_NaN());
+      ret[std::to_string(yearCol.first)] = Interp::wrap(yearCol.second);
+  }
+  clearData();
+  mWideData.clear();
+  mNumWideRows = 0;
+  return ret;
+}
+
+/*!
+ * \brief Run the query against the given Scenario context and return only
+ *        the values found.
+ * \details This avoids creating a DataFrame when the caller already knows the
+ *          paths, such as from a previous call to run, as the values are found
+ *          in the same order each time.
+ * \param aScenario The Scenario object which will serve as the
+ *                  query context from which to evaluate the query.
+ * \return The values found which are valid until this helper is run again.
+ */
+const std::vector<double>& GetDataHelper::runValues(Scenario* aScenario) {
+  clearData();
+  GCAMFusion<GetDataHelper> fusion(*this, mFilterSteps);
+  fusion.startFilter(aScenario);
+  return mDataVector;
+}
+
+/*!
+ * \brief Organize the data recorded so far into a DataFrame.
+ * \return A DataFrame where the columns include all the name/year
+ *         of the GCAM CONTAINER the user indicated they wanted to
+ *         record and the last column holds the values.
+ */
+DataFrame GetDataHelper::createDataFrame() const {
   // extract the data from the path tracking filters and
   // organize them as columns in a DataFrame
   DataFrame ret = Interp::createDataFrame();
@@ -136,6 +564,102 @@ DataFrame GetDataHelper::run(Scenario* aScenario) {
   return ret;
 }
 
+/*!
+ * \brief Clear the data recorded so far while keeping the memory allocated
+ *        so it can be reused.
+ */
+void GetDataHelper::clearData() {
+  mDataVector.clear();
+  for(auto path: mPathTracker) {
+      path->clearData();
+  }
+}
+
+/*!
+ * \brief Clear the data recorded so far and give back the memory of any
+ *        buffer which could hold more than aMaxRetainedRows.
+ * \details This should be called before keeping a helper around to be run
+ *          again so that it does not hold a copy of results which have already
+ *          been handed off while small buffers can still be reused.
+ * \param aMaxRetainedRows The largest number of rows to keep memory for.
+ */
+void GetDataHelper::releaseData(const size_t aMaxRetainedRows) {
+  releaseVector(mDataVector, aMaxRetainedRows);
+  for(auto path: mPathTracker) {
+      path->releaseData(aMaxRetainedRows);
+  }
+}
+
+/*!
+ * \brief Record a value which matched the query.
+ * \details If the value passes the value filter, if any, the tracking filters
+ *          will record their current values to include in this row.  If we are
+ *          handing off results in chunks and the chunk is full it will be passed
+ *          along to the callback.
+ * \param aValue The value which matched the query.
+ */
+void GetDataHelper::recordValue(const double aValue) {
+  if(mValueFilter && !mValueFilter->matches(aValue)) {
+      return;
+  }
+  if(mIsCount) {
+      ++mNumCounted;
+      return;
+  }
+  if(mIsWide) {
+      if(mWideYear == NO_WIDE_YEAR) {
+          Interp::stop("Wide output is only available when the query finds vectors of data by year.");
+      }
+      if(mIsNewWideRow) {
+          // record the path, excluding the year tracker which is last
+          for(size_t i = 0; i + 1 < mPathTracker.size(); ++i) {
+              mPathTracker[i]->recordPath();
+          }
+          ++mNumWideRows;
+          mIsNewWideRow = false;
+      }
+      std::vector<double>& yearCol = mWideData[mWideYear];
+      yearCol.resize(mNumWideRows, std::numeric_limits<double>::quiet_NaN());
+      yearCol[mNumWideRows - 1] = aValue;
+      return;
+  }
+  if(mIsDelta) {
+      std::vector<int> pathIDs(mPathTracker.size());
+      for(size_t i = 0; i < mPathTracker.size(); ++i) {
+          pathIDs[i] = mPathTracker[i]->internCurrent();
+      }
+      mDeltaCurr[pathIDs] += aValue;
+      return;
+  }
+  mDataVector.push_back(aValue);
+  for(auto path: mPathTracker) {
+      path->recordPath();
+  }
+  if(mChunkSize > 0 && mDataVector.size() >= mChunkSize) {
+      (*mChunkCallback)(createDataFrame());
+      clearData();
+  }
+}
+
+/*!
+ * \brief Record a row given the path values as interned by the path trackers.
+ * \param aPathIDs The interned path values, one for each path tracker.
+ * \param aValue The value for this row.
+ */
+void GetDataHelper::recordRow(const std::vector<int>& aPathIDs, const double aValue) {
+  mDataVector.push_back(aValue);
+  for(size_t i = 0; i < mPathTracker.size(); ++i) {
+      // the implicit year tracker may have been added after some rows were found
+      // in which case there is no year for those rows
+      if(i < aPathIDs.size()) {
+          mPathTracker[i]->recordInterned(aPathIDs[i]);
+      }
+      else {
+          mPathTracker[i]->recordMissing();
+      }
+  }
+}
+
 AMatchesValue* GetDataHelper::wrapPredicate(AMatchesValue* aToWrap, const std::string& aDataName, const bool aIsInt) {
     // if the user intended to record the value at this filter then we just
     // wrap whatever filter they set with the path tracking filter
@@ -153,30 +677,15 @@ AMatchesValue* GetDataHelper::wrapPredicate(AMatchesValue* aToWrap, const std::s
 
 template<>
 void GetDataHelper::processData(double& aData) {
-    // add the value which matched and have the tracking filters
-    // record their current values to include in this row
-    mDataVector.push_back(aData);
-    for(auto path: mPathTracker) {
-        path->recordPath();
-    }
+    recordValue(aData);
 }
 template<>
 void GetDataHelper::processData(Value& aData) {
-    // add the value which matched and have the tracking filters
-    // record their current values to include in this row
-    mDataVector.push_back(aData);
-    for(auto path: mPathTracker) {
-        path->recordPath();
-    }
+    recordValue(aData);
 }
 template<>
 void GetDataHelper::processData(int& aData) {
-    // add the value which matched and have the tracking filters
-    // record their current values to include in this row
-    mDataVector.push_back(aData);
-    for(auto path: mPathTracker) {
-        path->recordPath();
-    }
+    recordValue(aData);
 }
 template<>
 void GetDataHelper::processData(std::vector<int>& aData) {
@@ -229,13 +738,21 @@ void GetDataHelper::processData(std::map<unsigned int, double>& aData) {
       mPathTracker.push_back(new IntMatcherWrapper(createMatchesAny(), "year"));
       mHasYearInPath = true;
   }
-  for(auto iter = aData.begin(); iter != aData.end(); ++iter) {
+  // only visit the years which could match, if the user gave a year filter
+  // it has been pushed down to us to check here
+  AMatchesValue* yearMatcher = mYearRangeMatcher ? mYearRangeMatcher : *mPathTracker.rbegin();
+  // in wide mode this vector will become a new row
+  mIsNewWideRow = true;
+  forEachInYearRange(aData, mYearRangeStart, mYearRangeEnd, [&](auto aIter, const int aYear) {
     // update the year path tracker which would not have had to match thus far
     // as an ARRAY is not a CONTAINER
-    (*mPathTracker.rbegin())->matchesInt(GetIndexAsYear::convertIterToYear(aData, iter));
-    // delegate to processData to take care of the rest
-    processData((*iter).second);
-  }
+    if(yearMatcher->matchesInt(aYear)) {
+      mWideYear = aYear;
+      // delegate to processData to take care of the rest
+      processData((*aIter).second);
+    }
+  });
+  mWideYear = NO_WIDE_YEAR;
 }
 template<typename VecType>
 void GetDataHelper::vectorDataHelper(VecType& aDataVec) {
@@ -248,17 +765,29 @@ void GetDataHelper::vectorDataHelper(VecType& aDataVec) {
       mPathTracker.push_back(new IntMatcherWrapper(createMatchesAny(), "year"));
       mHasYearInPath = true;
   }
-  for(auto iter = aDataVec.begin(); iter != aDataVec.end(); ++iter) {
+  // only visit the years which could match, if the user gave a year filter
+  // it has been pushed down to us to check here
+  AMatchesValue* yearMatcher = mYearRangeMatcher ? mYearRangeMatcher : *mPathTracker.rbegin();
+  // in wide mode this vector will become a new row
+  mIsNewWideRow = true;
+  forEachInYearRange(aDataVec, mYearRangeStart, mYearRangeEnd, [&](auto aIter, const int aYear) {
     // update the year path tracker which would not have had to match thus far
     // as an ARRAY is not a CONTAINER
-    (*mPathTracker.rbegin())->matchesInt(GetIndexAsYear::convertIterToYear(aDataVec, iter));
-    // delegate to processData to take care of the rest
-    processData(*iter);
-  }
+    if(yearMatcher->matchesInt(aYear)) {
+      mWideYear = aYear;
+      // delegate to processData to take care of the rest
+      processData(*aIter);
+    }
+  });
+  mWideYear = NO_WIDE_YEAR;
 }
 
 template<typename T>
 void GetDataHelper::processData(T& aData) {
+  if(mIsCount && mCountAnyType) {
+      ++mNumCounted;
+      return;
+  }
   Interp::stop(string("Search found unexpected type: ")+string(typeid(T).name()));
 }
 
@@ -0,0 +1,66 @@
+#include "interp_interface.h"
+
+#include "market_state_collector.h"
+
+#include "marketplace/include/marketplace.h"
+#include "marketplace/include/market.h"
+
+using namespace std;
+using namespace Interp;
+
+/*!
+ * \brief Constructor.
+ * \param aMarketFilter A regular expression market names must match to be
+ *                      included or an empty string to include all markets.
+ */
+MarketStateCollector::MarketStateCollector(const std::string& aMarketFilter)
+{
+  if(!aMarketFilter.empty()) {
+    try {
+      mMarketFilter.reset(new std::regex(aMarketFilter, std::regex::nosubs | std::regex::optimize));
+    } catch(const std::regex_error& aError) {
+      Interp::stop("Could not parse market filter "+aMarketFilter+": "+aError.what());
+    }
+  }
+}
+
+/*!
+ * \brief Collect the state of all markets which match the filter.
+ * \param aMarketplace The marketplace to collect markets from.
+ * \param aStartPeriod The first model period to collect.
+ * \param aEndPeriod The last model period to collect (inclusive).
+ * \return A DataFrame with the columns market, period, price, supply, demand,
+ *         and solvable with one row per market per period.
+ */
+DataFrame MarketStateCollector::collect(const Marketplace* aMarketplace, const int aStartPeriod, const int aEndPeriod) {
+  mMarket.clear();
+  mPeriod.clear();
+  mPrice.clear();
+  mSupply.clear();
+  mDemand.clear();
+  mSolvable.clear();
+  for(int period = aStartPeriod; period <= aEndPeriod; ++period) {
+    aMarketplace->accept(this, period);
+  }
+
+  DataFrame ret = Interp::createDataFrame();
+  ret["market"] = Interp::wrap(mMarket);
+  ret["period"] = Interp::wrap(mPeriod);
+  ret["price"] = Interp::wrap(mPrice);
+  ret["supply"] = Interp::wrap(mSupply);
+  ret["demand"] = Interp::wrap(mDemand);
+  ret["solvable"] = Interp::wrap(mSolvable);
+  return ret;
+}
+
+void MarketStateCollector::startVisitMarket(const Market* aMarket, const int aPeriod) {
+  if(mMarketFilter && !std::regex_search(aMarket->getName(), *mMarketFilter)) {
+    return;
+  }
+  mMarket.push_back(aMarket->getName());
+  mPeriod.push_back(aPeriod);
+  mPrice.push_back(aMarket->getPrice());
+  mSupply.push_back(aMarket->getSupply());
+  mDemand.push_back(aMarket->getDemand());
+  mSolvable.push_back(aMarket->isSolvable() ? 1 : 0);
+}
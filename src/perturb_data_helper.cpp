@@ -0,0 +1,138 @@
+#include "interp_interface.h"
+
+#include "perturb_data_helper.h"
+
+#include "util/base/include/gcam_fusion.hpp"
+#include "util/base/include/gcam_data_containers.h"
+
+#include "year_range.h"
+
+#include <limits>
+
+using namespace std;
+using namespace Interp;
+
+const size_t PerturbDataHelper::NO_TARGET = std::numeric_limits<size_t>::max();
+
+/*!
+ * \brief Prepare to run the given query.
+ * \param aQuery The GCAM Fusion query to be parsed, in the same syntax as
+ *               for GetDataHelper.
+ */
+PerturbDataHelper::PerturbDataHelper(const std::string& aQuery):QueryProcessorBase(), mCurrIndex(0), mTargetIndex(NO_TARGET), mTargetValue(0.0)
+{
+    // a year filter on the data itself will be applied in vectorDataHelper
+    // exactly as GetDataHelper does so the values are found in the same order
+    mPushDownYearRange = true;
+    parseFilterString(aQuery);
+}
+
+/*!
+ * \brief Run the query and collect all of the values found.
+ * \param aScenario The Scenario object which will serve as the
+ *                  query context from which to evaluate the query.
+ * \return The values in the order the query found them.
+ */
+const std::vector<double>& PerturbDataHelper::getValues(Scenario* aScenario) {
+  mValues.clear();
+  mCurrIndex = 0;
+  mTargetIndex = NO_TARGET;
+  GCAMFusion<PerturbDataHelper> fusion(*this, mFilterSteps);
+  fusion.startFilter(aScenario);
+  return mValues;
+}
+
+/*!
+ * \brief Run the query and overwrite a single value found.
+ * \param aScenario The Scenario object which will serve as the
+ *                  query context from which to evaluate the query.
+ * \param aIndex The index of the value to set in the order the query finds them.
+ * \param aValue The value to set.
+ */
+void PerturbDataHelper::setValue(Scenario* aScenario, const size_t aIndex, const double aValue) {
+  mCurrIndex = 0;
+  mTargetIndex = aIndex;
+  mTargetValue = aValue;
+  GCAMFusion<PerturbDataHelper> fusion(*this, mFilterSteps);
+  fusion.startFilter(aScenario);
+  mTargetIndex = NO_TARGET;
+  if(mCurrIndex <= aIndex) {
+      Interp::stop("Could not find value "+std::to_string(aIndex)+" to set, the query only found "+std::to_string(mCurrIndex));
+  }
+}
+
+template<typename DataType>
+void PerturbDataHelper::visitData(DataType& aData) {
+  if(mTargetIndex == NO_TARGET) {
+      mValues.push_back(aData);
+  }
+  else if(mCurrIndex == mTargetIndex) {
+      aData = mTargetValue;
+  }
+  ++mCurrIndex;
+}
+
+// GCAM Fusion callbacks with specializations for all of the types that
+// we support, note only real valued data can be perturbed:
+
+template<>
+void PerturbDataHelper::processData(double& aData) {
+    visitData(aData);
+}
+template<>
+void PerturbDataHelper::processData(Value& aData) {
+    visitData(aData);
+}
+template<>
+void PerturbDataHelper::processData(std::vector<double>& aData) {
+    vectorDataHelper(aData);
+}
+template<>
+void PerturbDataHelper::processData(std::vector<Value>& aData) {
+    vectorDataHelper(aData);
+}
+template<>
+void PerturbDataHelper::processData(objects::PeriodVector<double>& aData) {
+    vectorDataHelper(aData);
+}
+template<>
+void PerturbDataHelper::processData(objects::PeriodVector<Value>& aData) {
+    vectorDataHelper(aData);
+}
+template<>
+void PerturbDataHelper::processData(objects::TechVintageVector<double>& aData) {
+  vectorDataHelper(aData);
+}
+template<>
+void PerturbDataHelper::processData(objects::TechVintageVector<Value>& aData) {
+  vectorDataHelper(aData);
+}
+template<>
+void PerturbDataHelper::processData(objects::YearVector<double>& aData) {
+  vectorDataHelper(aData);
+}
+template<>
+void PerturbDataHelper::processData(std::map<unsigned int, double>& aData) {
+  // only visit the years which could match, if the user gave a year filter
+  // it has been pushed down to us to check here
+  forEachInYearRange(aData, mYearRangeStart, mYearRangeEnd, [&](auto aIter, const int aYear) {
+    if(!mYearRangeMatcher || mYearRangeMatcher->matchesInt(aYear)) {
+      processData((*aIter).second);
+    }
+  });
+}
+template<typename VecType>
+void PerturbDataHelper::vectorDataHelper(VecType& aDataVec) {
+  // only visit the years which could match, if the user gave a year filter
+  // it has been pushed down to us to check here
+  forEachInYearRange(aDataVec, mYearRangeStart, mYearRangeEnd, [&](auto aIter, const int aYear) {
+    if(!mYearRangeMatcher || mYearRangeMatcher->matchesInt(aYear)) {
+      processData(*aIter);
+    }
+  });
+}
+
+template<typename T>
+void PerturbDataHelper::processData(T& aData) {
+  Interp::stop(string("Search found unexpected type, only real valued data can be perturbed: ")+string(typeid(T).name()));
+}
@@ -0,0 +1,129 @@
+#include "interp_interface.h"
+
+#include "plugin_manager.h"
+
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+using namespace std;
+
+PluginManager::PluginManager()
+{
+}
+
+PluginManager::~PluginManager() {
+  clear();
+}
+
+/*!
+ * \brief Load a plugin from a shared library and create an instance of it.
+ * \param aPath The path to the shared library.
+ * \param aOptions An arbitrary string which is passed along to the plugin when
+ *                 it is created.
+ */
+void PluginManager::load(const std::string& aPath, const std::string& aOptions) {
+#if defined(_WIN32)
+  Interp::stop("Loading plugins is not available on Windows.");
+#else
+  LoadedPlugin loaded = { 0, 0, 0 };
+  loaded.mLibrary = dlopen(aPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if(!loaded.mLibrary) {
+    Interp::stop("Could not load plugin "+aPath+": "+std::string(dlerror()));
+  }
+  GcamwrapperPluginEntry entry = reinterpret_cast<GcamwrapperPluginEntry>(dlsym(loaded.mLibrary, GCAMWRAPPER_PLUGIN_ENTRY_NAME));
+  if(!entry) {
+    dlclose(loaded.mLibrary);
+    Interp::stop(aPath+" is not a gcamwrapper plugin, it does not export "+GCAMWRAPPER_PLUGIN_ENTRY_NAME);
+  }
+  loaded.mPlugin = entry();
+  if(!loaded.mPlugin || loaded.mPlugin->mAPIVersion != GCAMWRAPPER_PLUGIN_API_VERSION) {
+    dlclose(loaded.mLibrary);
+    Interp::stop("Plugin "+aPath+" was not built for plugin API version "+std::to_string(GCAMWRAPPER_PLUGIN_API_VERSION));
+  }
+  if(loaded.mPlugin->mCreate) {
+    loaded.mState = loaded.mPlugin->mCreate(aOptions.c_str());
+    if(!loaded.mState) {
+      dlclose(loaded.mLibrary);
+      Interp::stop("Failed to create plugin "+std::string(loaded.mPlugin->mName ? loaded.mPlugin->mName : aPath));
+    }
+  }
+  mPlugins.push_back(loaded);
+#endif
+}
+
+/*!
+ * \brief Destroy and unload all plugins.
+ */
+void PluginManager::clear() {
+  // unload in the reverse order in case later plugins depend on earlier ones
+  for(auto iter = mPlugins.rbegin(); iter != mPlugins.rend(); ++iter) {
+    unload(*iter);
+  }
+  mPlugins.clear();
+}
+
+bool PluginManager::empty() const {
+  return mPlugins.empty();
+}
+
+std::vector<std::string> PluginManager::getNames() const {
+  std::vector<std::string> ret;
+  for(const auto& loaded : mPlugins) {
+    ret.push_back(loaded.mPlugin->mName ? loaded.mPlugin->mName : "");
+  }
+  return ret;
+}
+
+/*!
+ * \brief Call the post init hook of all plugins.
+ * \details The error is returned rather than raised so the caller may finish
+ *          updating the model state first.  No more plugins are called once one
+ *          has failed.
+ * \param aScenario The scenario being run.
+ * \param aPeriod The model period which has just been initialized.
+ * \return An error message or an empty string if all plugins succeeded.
+ */
+std::string PluginManager::postInit(Scenario* aScenario, const int aPeriod) {
+  for(const auto& loaded : mPlugins) {
+    if(loaded.mPlugin->mPostInit) {
+      const char* error = loaded.mPlugin->mPostInit(loaded.mState, aScenario, aPeriod);
+      if(error) {
+        return formatError(loaded, error, "post init");
+      }
+    }
+  }
+  return std::string();
+}
+
+/*!
+ * \brief Call the after period hook of all plugins.
+ * \details The error is returned as for postInit.
+ * \param aScenario The scenario being run.
+ * \param aPeriod The model period which has just been solved.
+ * \return An error message or an empty string if all plugins succeeded.
+ */
+std::string PluginManager::afterPeriod(Scenario* aScenario, const int aPeriod) {
+  for(const auto& loaded : mPlugins) {
+    if(loaded.mPlugin->mAfterPeriod) {
+      const char* error = loaded.mPlugin->mAfterPeriod(loaded.mState, aScenario, aPeriod);
+      if(error) {
+        return formatError(loaded, error, "after period");
+      }
+    }
+  }
+  return std::string();
+}
+
+void PluginManager::unload(const LoadedPlugin& aPlugin) {
+#if !defined(_WIN32)
+  if(aPlugin.mPlugin->mDestroy && aPlugin.mState) {
+    aPlugin.mPlugin->mDestroy(aPlugin.mState);
+  }
+  dlclose(aPlugin.mLibrary);
+#endif
+}
+
+std::string PluginManager::formatError(const LoadedPlugin& aPlugin, const char* aError, const char* aHook) {
+  return "Plugin "+std::string(aPlugin.mPlugin->mName ? aPlugin.mPlugin->mName : "")+" failed in "+aHook+": "+aError;
+}
@@ -0,0 +1,257 @@
+#include "interp_interface.h"
+
+#include "price_checkpoint.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#include "containers/include/scenario.h"
+#include "solution/util/include/solution_info.h"
+#include "solution/util/include/solution_info_set.h"
+#include "solution/util/include/solution_info_param_parser.h"
+
+using namespace std;
+using namespace Interp;
+
+extern Scenario* scenario;
+
+//! Identifies a checkpoint file and the version of its format
+static const char CHECKPOINT_MAGIC[8] = { 'G', 'C', 'W', 'C', 'K', 'P', 'T', 1 };
+
+PriceCheckpoint::PriceCheckpoint():mSuspended(false)
+{
+}
+
+PriceCheckpoint::~PriceCheckpoint() {
+  if(mWriter.joinable()) {
+    mWriter.join();
+  }
+}
+
+/*!
+ * \brief Set the file to write checkpoints to.
+ * \details Any periods already recorded are discarded so the file will only
+ *          contain periods run from now on.
+ * \param aFile The file to write to or an empty string to stop checkpointing.
+ */
+void PriceCheckpoint::setFile(const std::string& aFile) {
+  wait();
+  mFile = aFile;
+  mPeriods.clear();
+}
+
+const std::string& PriceCheckpoint::getFile() const {
+  return mFile;
+}
+
+/*!
+ * \brief Stop checkpointing without waiting on any pending write.
+ * \details This is meant for a forked worker process which must not write to the
+ *          parent's checkpoint and which does not have the parent's writer thread.
+ *          The parent must have called wait before forking.
+ */
+void PriceCheckpoint::disable() {
+  mFile.clear();
+}
+
+/*!
+ * \brief Temporarily ignore any periods which are recorded.
+ * \details This is meant for when an already checkpointed period is re-solved
+ *          with perturbed data, which would otherwise replace its prices and drop
+ *          all of the later periods from the checkpoint.
+ * \param aSuspended If recording should be suspended.
+ */
+void PriceCheckpoint::setSuspended(const bool aSuspended) {
+  mSuspended = aSuspended;
+}
+
+/*!
+ * \brief Record the prices of the given period, which has just been solved, and
+ *        write the checkpoint.
+ * \details Any later periods previously recorded are discarded as they are no
+ *          longer consistent with this period.  Nothing is done if no file is set
+ *          or recording is suspended.
+ * \param aPeriod The model period which has just been solved.
+ */
+void PriceCheckpoint::record(const int aPeriod) {
+  if(mFile.empty() || mSuspended) {
+    return;
+  }
+  SolutionInfoSet solnInfoSet( scenario->getMarketplace() );
+  SolutionInfoParamParser solnParams;
+  solnInfoSet.init( aPeriod, 0.001, 0.001, &solnParams );
+
+  MarketPrices& prices = mPeriods[aPeriod];
+  prices.clear();
+  prices.reserve(solnInfoSet.getNumSolvable());
+  for(unsigned int i = 0; i < solnInfoSet.getNumSolvable(); ++i) {
+    const SolutionInfo& info = solnInfoSet.getSolvable(i);
+    prices.emplace_back(info.getName().get(), info.getPrice());
+  }
+  mPeriods.erase(mPeriods.upper_bound(aPeriod), mPeriods.end());
+
+  // only one write at a time, the thread gets its own copy of the data
+  wait();
+  mWriter = std::thread(&PriceCheckpoint::write, mFile, mPeriods, std::ref(mWriteError));
+}
+
+/*!
+ * \brief Wait for any pending write to finish and warn if it failed.
+ */
+void PriceCheckpoint::wait() {
+  if(mWriter.joinable()) {
+    mWriter.join();
+  }
+  if(!mWriteError.empty()) {
+    std::string error;
+    std::swap(error, mWriteError);
+    Interp::warning(error);
+  }
+}
+
+/*!
+ * \brief Write the given periods to a checkpoint file.
+ * \details This is run in the writer thread so errors are reported through
+ *          aError rather than the interpreter.
+ * \param aFile The checkpoint file to replace.
+ * \param aPeriods The periods to write.
+ * \param aError Set to an error message if the write failed.
+ */
+void PriceCheckpoint::write(const std::string& aFile, const std::map<int, MarketPrices>& aPeriods, std::string& aError) {
+  std::string buffer(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+  auto append = [&buffer](const auto& aValue) {
+    buffer.append(reinterpret_cast<const char*>(&aValue), sizeof(aValue));
+  };
+  append(static_cast<uint32_t>(aPeriods.size()));
+  for(const auto& period : aPeriods) {
+    append(static_cast<int32_t>(period.first));
+    append(static_cast<uint32_t>(period.second.size()));
+    for(const auto& market : period.second) {
+      append(static_cast<uint32_t>(market.first.size()));
+      buffer.append(market.first);
+      append(market.second);
+    }
+  }
+
+  const std::string tempFile = aFile + ".tmp";
+  FILE* file = fopen(tempFile.c_str(), "wb");
+  if(!file) {
+    aError = "Could not open checkpoint file "+tempFile+": "+std::strerror(errno);
+    return;
+  }
+  bool success = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size() && fflush(file) == 0;
+#if !defined(_WIN32)
+  // make sure the data is on disk before it replaces the last checkpoint
+  success = success && fsync(fileno(file)) == 0;
+#endif
+  success = fclose(file) == 0 && success;
+  if(!success) {
+    aError = "Could not write checkpoint file "+tempFile+": "+std::strerror(errno);
+    std::remove(tempFile.c_str());
+    return;
+  }
+#if defined(_WIN32)
+  // rename will not replace an existing file on Windows
+  std::remove(aFile.c_str());
+#endif
+  if(std::rename(tempFile.c_str(), aFile.c_str()) != 0) {
+    aError = "Could not replace checkpoint file "+aFile+": "+std::strerror(errno);
+  }
+}
+
+/*!
+ * \brief Read the periods from a checkpoint file, replacing any recorded.
+ * \param aFile The checkpoint file to read.
+ */
+void PriceCheckpoint::read(const std::string& aFile) {
+  std::ifstream in(aFile.c_str(), std::ios::binary);
+  if(!in) {
+    Interp::stop("Could not open checkpoint file "+aFile);
+  }
+  std::stringstream contents;
+  contents << in.rdbuf();
+  const std::string buffer = contents.str();
+
+  const char* pos = buffer.data();
+  const char* end = pos + buffer.size();
+  auto read = [&](auto& aValue) {
+    if(static_cast<size_t>(end - pos) < sizeof(aValue)) {
+      Interp::stop("Checkpoint file "+aFile+" is truncated");
+    }
+    std::memcpy(&aValue, pos, sizeof(aValue));
+    pos += sizeof(aValue);
+  };
+  char magic[sizeof(CHECKPOINT_MAGIC)];
+  read(magic);
+  if(std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+    Interp::stop(aFile+" is not a checkpoint file or was written by a different version");
+  }
+
+  mPeriods.clear();
+  uint32_t numPeriods;
+  read(numPeriods);
+  for(uint32_t i = 0; i < numPeriods; ++i) {
+    int32_t period;
+    uint32_t numMarkets;
+    read(period);
+    read(numMarkets);
+    MarketPrices& prices = mPeriods[period];
+    prices.reserve(numMarkets);
+    for(uint32_t j = 0; j < numMarkets; ++j) {
+      uint32_t nameLen;
+      read(nameLen);
+      if(static_cast<size_t>(end - pos) < nameLen) {
+        Interp::stop("Checkpoint file "+aFile+" is truncated");
+      }
+      std::string name(pos, nameLen);
+      pos += nameLen;
+      double price;
+      read(price);
+      prices.emplace_back(std::move(name), price);
+    }
+  }
+}
+
+/*!
+ * \brief Get the last period which has been recorded.
+ * \return The last period recorded or -1 if none have been.
+ */
+int PriceCheckpoint::getLastPeriod() const {
+  return mPeriods.empty() ? -1 : (*mPeriods.rbegin()).first;
+}
+
+/*!
+ * \brief Set the recorded prices of the given period into the marketplace.
+ * \details This should be called after the period has been initialized and
+ *          before it is solved so the solver starts from these prices.  Markets
+ *          which are not in the checkpoint are left as they are.
+ * \param aPeriod The model period to restore.
+ */
+void PriceCheckpoint::restore(const int aPeriod) const {
+  auto periodIter = mPeriods.find(aPeriod);
+  if(periodIter == mPeriods.end()) {
+    return;
+  }
+  std::unordered_map<std::string, double> prices((*periodIter).second.begin(), (*periodIter).second.end());
+
+  SolutionInfoSet solnInfoSet( scenario->getMarketplace() );
+  SolutionInfoParamParser solnParams;
+  solnInfoSet.init( aPeriod, 0.001, 0.001, &solnParams );
+  for(unsigned int i = 0; i < solnInfoSet.getNumSolvable(); ++i) {
+    SolutionInfo& info = solnInfoSet.getSolvable(i);
+    auto priceIter = prices.find(info.getName().get());
+    if(priceIter != prices.end()) {
+      info.setPrice((*priceIter).second);
+    }
+  }
+  solnInfoSet.updateToMarkets();
+}
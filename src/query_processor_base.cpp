@@ -2,6 +2,11 @@
 
 #include "query_processor_base.h"
 
+#include <limits>
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
 #include "util/base/include/gcam_fusion.hpp"
 
 // includes to get enums
@@ -25,10 +30,105 @@ public:
     }
 };
 
+/*!
+ * \brief A wrapper around an AMatchesValue which keeps track of the last
+ *        year it matched.
+ * \details This allows Set Data to determine which model periods were affected
+ *          by the data it set.
+ */
+class YearTracker : public AMatchesValue {
+public:
+    YearTracker(AMatchesValue* aToWrap):mToWrap(aToWrap), mCurrYear(QueryProcessorBase::ALL_YEARS_SET)
+    {
+    }
+    virtual ~YearTracker() {
+        delete mToWrap;
+    }
+    virtual bool matchesInt( const int aIntToTest ) const {
+        bool matches = mToWrap->matchesInt(aIntToTest);
+        if(matches) {
+            const_cast<YearTracker*>(this)->mCurrYear = aIntToTest;
+        }
+        return matches;
+    }
+    virtual bool isExactMatch() const {
+        return mToWrap->isExactMatch();
+    }
+    int getCurrentYear() const {
+        return mCurrYear;
+    }
+private:
+    //! The actual AMatchesValue which determines if the current path matches the query
+    AMatchesValue* mToWrap;
+    //! The last year which matched
+    int mCurrYear;
+};
+
+/*!
+ * \brief A wrapper around an AMatchesValue which counts how many times it was
+ *        evaluated and matched and the time spent doing so.
+ * \details This allows a query to be profiled to find out which filter steps
+ *          are expensive.
+ */
+class StepProfiler : public AMatchesValue {
+public:
+    StepProfiler(AMatchesValue* aToWrap):mToWrap(aToWrap), mNumEvaluated(0), mNumMatched(0), mTime(0)
+    {
+    }
+    virtual ~StepProfiler() {
+        delete mToWrap;
+    }
+    virtual bool matchesString( const std::string& aStrToTest ) const {
+        auto start = std::chrono::steady_clock::now();
+        bool matches = mToWrap->matchesString(aStrToTest);
+        const_cast<StepProfiler*>(this)->record(start, matches);
+        return matches;
+    }
+    virtual bool matchesInt( const int aIntToTest ) const {
+        auto start = std::chrono::steady_clock::now();
+        bool matches = mToWrap->matchesInt(aIntToTest);
+        const_cast<StepProfiler*>(this)->record(start, matches);
+        return matches;
+    }
+    virtual bool isExactMatch() const {
+        return mToWrap->isExactMatch();
+    }
+    double getNumEvaluated() const {
+        return mNumEvaluated;
+    }
+    double getNumMatched() const {
+        return mNumMatched;
+    }
+    double getTime() const {
+        return std::chrono::duration<double>(mTime).count();
+    }
+private:
+    //! The actual AMatchesValue which determines if the current path matches the query
+    AMatchesValue* mToWrap;
+    //! The number of times the predicate was evaluated
+    size_t mNumEvaluated;
+    //! The number of times the predicate matched
+    size_t mNumMatched;
+    //! The total time spent evaluating the predicate
+    std::chrono::steady_clock::duration mTime;
+
+    void record(const std::chrono::steady_clock::time_point& aStart, const bool aMatches) {
+        mTime += std::chrono::steady_clock::now() - aStart;
+        ++mNumEvaluated;
+        if(aMatches) {
+            ++mNumMatched;
+        }
+    }
+};
+
+const int QueryProcessorBase::NO_DATA_SET = std::numeric_limits<int>::max();
+const int QueryProcessorBase::ALL_YEARS_SET = std::numeric_limits<int>::min();
+
 QueryProcessorBase::~QueryProcessorBase() {
   for(auto step : mFilterSteps) {
     delete step;
   }
+  delete mYearRangeMatcher;
 }
 
 /*!
@@ -42,27 +142,210 @@ AMatchesValue* QueryProcessorBase::createMatchesAny() const {
     return new MatchesAny();
 }
 
+/*!
+ * \brief Wrap the given predicate so that it keeps track of the last year matched.
+ * \details The wrapper will be included when determining the years affected
+ *          by markDataSet.
+ * \param aToWrap The predicate to wrap.
+ * \return The wrapped predicate which now owns aToWrap.
+ */
+AMatchesValue* QueryProcessorBase::trackYear(AMatchesValue* aToWrap) {
+    YearTracker* ret = new YearTracker(aToWrap);
+    mYearTrackers.push_back(ret);
+    return ret;
+}
+
+/*!
+ * \brief Record that the query has set data at the current path.
+ * \details The earliest year set is updated with the earliest year currently
+ *          matched by any of the year trackers in the path.  If there are no year
+ *          trackers we have to assume all years may have been affected.
+ */
+void QueryProcessorBase::markDataSet() {
+    ++mNumDataSet;
+    if(mYearTrackers.empty()) {
+        mEarliestSetYear = ALL_YEARS_SET;
+        return;
+    }
+    for(auto tracker : mYearTrackers) {
+        mEarliestSetYear = std::min(mEarliestSetYear, tracker->getCurrentYear());
+    }
+}
+
+/*!
+ * \brief Wrap the given predicate so that the work it does is profiled, if
+ *        profiling is enabled.
+ * \param aToWrap The predicate to wrap.
+ * \param aFilterStepStr The unparsed filter step to identify the predicate by.
+ * \return The wrapped predicate which now owns aToWrap, or just aToWrap if not
+ *         profiling.
+ */
+AMatchesValue* QueryProcessorBase::profilePredicate(AMatchesValue* aToWrap, const std::string& aFilterStepStr) {
+    if(!mProfile) {
+        return aToWrap;
+    }
+    StepProfiler* ret = new StepProfiler(aToWrap);
+    mStepProfiles.emplace_back(aFilterStepStr, ret);
+    return ret;
+}
+
+/*!
+ * \brief Organize the profile of a query which was parsed with mProfile set.
+ * \details Each filter step with a predicate reports how many times it was
+ *          evaluated, which is the number of nodes the step visited, how many
+ *          of those matched, and the time spent evaluating the predicate.  Steps
+ *          without a predicate visit every node without evaluating anything so
+ *          their counts are not available.  The time spent in the sub-tree below
+ *          each step can not be measured as it is interleaved by GCAM Fusion.
+ * \param aSetupTime The time spent parsing the query, including reading any
+ *                   DataFrame which is needed to do so.
+ * \param aTraversalTime The time spent running the query.
+ * \param aConversionTime The time spent organizing the results.
+ * \param aNumLeaves The number of values recorded or set.
+ * \return A List of a DataFrame with a row for each filter step and a DataFrame
+ *         summarizing the run.
+ */
+Interp::List QueryProcessorBase::createProfile(const double aSetupTime, const double aTraversalTime, const double aConversionTime,
+                                               const size_t aNumLeaves) const
+{
+    vector<int> step;
+    vector<string> filter;
+    vector<double> evaluated;
+    vector<double> matched;
+    vector<double> time;
+    for(size_t i = 0; i < mStepProfiles.size(); ++i) {
+        const StepProfiler* profiler = mStepProfiles[i].second;
+        step.push_back(i + 1);
+        filter.push_back(mStepProfiles[i].first);
+        evaluated.push_back(profiler ? profiler->getNumEvaluated() : std::numeric_limits<double>::quiet_NaN());
+        matched.push_back(profiler ? profiler->getNumMatched() : std::numeric_limits<double>::quiet_NaN());
+        time.push_back(profiler ? profiler->getTime() : std::numeric_limits<double>::quiet_NaN());
+    }
+    DataFrame steps = Interp::createDataFrame();
+    steps["step"] = Interp::wrap(step);
+    steps["filter"] = Interp::wrap(filter);
+    steps["evaluated"] = Interp::wrap(evaluated);
+    steps["matched"] = Interp::wrap(matched);
+    steps["time"] = Interp::wrap(time);
+
+    DataFrame summary = Interp::createDataFrame();
+    summary["setup_time"] = Interp::wrap(vector<double>(1, aSetupTime));
+    summary["traversal_time"] = Interp::wrap(vector<double>(1, aTraversalTime));
+    summary["conversion_time"] = Interp::wrap(vector<double>(1, aConversionTime));
+    summary["leaves"] = Interp::wrap(vector<double>(1, static_cast<double>(aNumLeaves)));
+
+    Interp::List ret = Interp::createList(2);
+    Interp::setListAt(ret, 0, steps);
+    Interp::setListAt(ret, 1, summary);
+    return ret;
+}
+
+/*!
+ * \brief Translate the options of a YearFilter into the range of years it
+ *        could possibly match.
+ * \details Only the standard comparison predicates can be translated, anything
+ *          else leaves the full range and will rely on checking mYearRangeMatcher.
+ * \param aFilterOptions The parsed components of a YearFilter.
+ */
+void QueryProcessorBase::setYearRange(const std::vector<std::string>& aFilterOptions) {
+    mYearRangeStart = std::numeric_limits<int>::min();
+    mYearRangeEnd = std::numeric_limits<int>::max();
+    if(aFilterOptions.size() < 3) {
+        return;
+    }
+    const int year = boost::lexical_cast<int>( aFilterOptions[ 2 ] );
+    if( aFilterOptions[ 1 ] == "IntEquals" ) {
+        mYearRangeStart = year;
+        mYearRangeEnd = year;
+    }
+    else if( aFilterOptions[ 1 ] == "IntGreaterThan" ) {
+        mYearRangeStart = year + 1;
+    }
+    else if( aFilterOptions[ 1 ] == "IntGreaterThanEq" ) {
+        mYearRangeStart = year;
+    }
+    else if( aFilterOptions[ 1 ] == "IntLessThan" ) {
+        mYearRangeEnd = year - 1;
+    }
+    else if( aFilterOptions[ 1 ] == "IntLessThanEq" ) {
+        mYearRangeEnd = year;
+    }
+}
+
+/*!
+ * \brief Get the earliest year of data which was set by this query.
+ * \return The earliest year set, NO_DATA_SET if nothing was set, or ALL_YEARS_SET
+ *         if data was set without a year in the path.
+ */
+int QueryProcessorBase::getEarliestSetYear() const {
+    return mEarliestSetYear;
+}
+
+/*!
+ * \brief Get the number of values which have been set by this query.
+ * \return The number of times markDataSet has been called.
+ */
+size_t QueryProcessorBase::getNumDataSet() const {
+    return mNumDataSet;
+}
+
+/*!
+ * \brief The lookup from XML name to enum index for each enum type which may be
+ *        used in an EnumFilter.
+ */
+typedef std::unordered_map<std::string, std::unordered_map<std::string, int> > EnumRegistry;
+
+/*!
+ * \brief Build the lookup from XML name to enum index for a single enum type.
+ * \param aEnd The number of values in the enum.
+ * \param aToXMLName A function to convert an enum to the name used in the XML.
+ * \return The lookup for the enum type.
+ */
+template<typename EnumType, typename ToXMLName>
+std::unordered_map<std::string, int> buildEnumLookup(const int aEnd, ToXMLName aToXMLName) {
+    std::unordered_map<std::string, int> lookup;
+    lookup.reserve(aEnd);
+    for(int i = 0; i < aEnd; ++i) {
+        lookup.emplace(aToXMLName(static_cast<EnumType>(i)), i);
+    }
+    return lookup;
+}
+
+/*!
+ * \brief Get the registry of all of the enum types which are supported.
+ * \details The registry is built once, on first use, so that converting names
+ *          for every row of a DataFrame is just a hash lookup.  To support a new
+ *          enum type it just needs to be added here.
+ * \return The registry of enum lookups by enum type name.
+ */
+static const EnumRegistry& getEnumRegistry() {
+    static const EnumRegistry registry = {
+        { "AccountType", buildEnumLookup<NationalAccount::AccountType>(NationalAccount::AccountType::END,
+            [](NationalAccount::AccountType aType) { return std::string(NationalAccount::enumToXMLName(aType)); }) }
+    };
+    return registry;
+}
+
 /*!
  * \brief Convert an "XML name" to the enum representation.
- * \details We are currently only supporting some enum "types".  We will
- *          rely on GCAM having an `enumToXMLName` or equivalent method to
- *          do the actual translation.
+ * \details The enum types which are supported are those in the registry built
+ *          by getEnumRegistry.
  * \param aEnumType The type of enum we are trying to translate.
  * \param aXMLName The string to be converted.
  * \return The enum converted to index to be generically utilized to index into
  *         a vector of enum values.
  */
 int QueryProcessorBase::convertToEnum(const std::string& aEnumType, const std::string& aXMLName) const {
-    if(aEnumType == "AccountType") {
-        for(int i = 0; i < NationalAccount::AccountType::END; ++i) {
-            if(aXMLName == NationalAccount::enumToXMLName(static_cast<NationalAccount::AccountType>(i))) {
-                return i;
-            }
-        }
+    const EnumRegistry& registry = getEnumRegistry();
+    auto typeIter = registry.find(aEnumType);
+    if(typeIter == registry.end()) {
+        Interp::stop("Unknown enum type: "+aEnumType);
+    }
+    auto nameIter = (*typeIter).second.find(aXMLName);
+    if(nameIter == (*typeIter).second.end()) {
         Interp::stop("Could not match "+aXMLName+ " to enum in type: "+aEnumType);
     }
-    Interp::stop("Unknown enum type: "+aEnumType);
-    return -1;
+    return (*nameIter).second;
 }
 
 /*!
@@ -151,6 +434,11 @@ FilterStep* QueryProcessorBase::parseFilterStepStr( const std::string& aFilterSt
     auto openBracketIter = std::find( aFilterStepStr.begin(), aFilterStepStr.end(), '[' );
     if( openBracketIter == aFilterStepStr.end() ) {
         // no filter just the data name
+        if(mProfile) {
+            // there is no predicate to profile but keep the step so they
+            // line up with the query
+            mStepProfiles.emplace_back(aFilterStepStr, nullptr);
+        }
         return new FilterStep( aFilterStepStr );
     }
     else {
@@ -182,6 +470,7 @@ FilterStep* QueryProcessorBase::parseFilterStepStr( const std::string& aFilterSt
                 matcher = wrapPredicate(matcher, "index", true);
             }
 
+            matcher = profilePredicate(matcher, aFilterStepStr);
             filterStep = new FilterStep( dataName, new IndexFilter( matcher ) );
         }
         else if( filterOptions[ 0 ] == "NamedFilter" ) {
@@ -189,6 +478,7 @@ FilterStep* QueryProcessorBase::parseFilterStepStr( const std::string& aFilterSt
                 matcher = wrapPredicate(matcher, dataName, false);
             }
 
+            matcher = profilePredicate(matcher, aFilterStepStr);
             filterStep = new FilterStep( dataName, new NamedFilter( matcher ) );
         }
         else if( filterOptions[ 0 ] == "YearFilter" ) {
@@ -196,7 +486,21 @@ FilterStep* QueryProcessorBase::parseFilterStepStr( const std::string& aFilterSt
                 matcher = wrapPredicate(matcher, aIsLastStep ? "year" : dataName, true);
             }
 
-            filterStep = new FilterStep( dataName, new YearFilter( matcher ) );
+            if(mTrackYears) {
+                matcher = trackYear(matcher);
+            }
+            matcher = profilePredicate(matcher, aFilterStepStr);
+
+            if(aIsLastStep && isRead && mPushDownYearRange) {
+                // the subclass will apply this filter itself when it gets handed
+                // the full vector of data
+                setYearRange(filterOptions);
+                mYearRangeMatcher = matcher;
+                filterStep = new FilterStep( dataName );
+            }
+            else {
+                filterStep = new FilterStep( dataName, new YearFilter( matcher ) );
+            }
         }
         else {
             Interp::stop("Unknown filter attribute: " + filterOptions[ 0 ]);
@@ -0,0 +1,230 @@
+#include "interp_interface.h"
+
+#include "query_result_writer.h"
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+#if __HAVE_ARROW__
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/feather.h>
+#include <parquet/arrow/writer.h>
+#endif
+
+using namespace std;
+
+/*!
+ * \brief Write query results as comma separated values.
+ * \details This format is always available.  Rows are written by walking all of
+ *          the columns in parallel so no intermediate copy of the data is made.
+ *          Missing/non-finite values are written as NA / Inf / -Inf which both R
+ *          and pandas read back correctly.
+ */
+class CSVResultWriter : public QueryResultWriter {
+public:
+  virtual void addColumn(const std::string& aName, const std::vector<std::string>& aData) {
+    Column col = { aName, &aData, 0, 0 };
+    addColumn(col, aData.size());
+  }
+
+  virtual void addColumn(const std::string& aName, const std::vector<int>& aData) {
+    Column col = { aName, 0, &aData, 0 };
+    addColumn(col, aData.size());
+  }
+
+  virtual void addColumn(const std::string& aName, const std::vector<double>& aData) {
+    Column col = { aName, 0, 0, &aData };
+    addColumn(col, aData.size());
+  }
+
+  virtual void write(const std::string& aFileName) {
+    ofstream out(aFileName.c_str());
+    if(!out) {
+      Interp::stop("Could not open "+aFileName+" for writing.");
+    }
+    out << setprecision(numeric_limits<double>::max_digits10);
+    for(size_t col = 0; col < mColumns.size(); ++col) {
+      if(col > 0) {
+        out << ',';
+      }
+      writeString(out, mColumns[col].mName);
+    }
+    out << '\n';
+    for(size_t row = 0; row < mNumRows; ++row) {
+      for(size_t col = 0; col < mColumns.size(); ++col) {
+        if(col > 0) {
+          out << ',';
+        }
+        const Column& currCol = mColumns[col];
+        if(currCol.mStrData) {
+          writeString(out, (*currCol.mStrData)[row]);
+        }
+        else if(currCol.mIntData) {
+          out << (*currCol.mIntData)[row];
+        }
+        else {
+          writeDouble(out, (*currCol.mDoubleData)[row]);
+        }
+      }
+      out << '\n';
+    }
+    if(!out) {
+      Interp::stop("Failed while writing "+aFileName);
+    }
+  }
+
+private:
+  //! A reference to a column of data, only one of the data pointers will be set
+  struct Column {
+    std::string mName;
+    const std::vector<std::string>* mStrData;
+    const std::vector<int>* mIntData;
+    const std::vector<double>* mDoubleData;
+  };
+
+  //! The columns in the order they should be written
+  std::vector<Column> mColumns;
+
+  //! The number of rows which all columns must share
+  size_t mNumRows = 0;
+
+  void addColumn(const Column& aColumn, const size_t aNumRows) {
+    if(!mColumns.empty() && aNumRows != mNumRows) {
+      Interp::stop("Column "+aColumn.mName+" does not have the same number of rows as the others.");
+    }
+    mNumRows = aNumRows;
+    mColumns.push_back(aColumn);
+  }
+
+  static void writeString(ostream& aOut, const std::string& aValue) {
+    // only quote when required to keep files small
+    if(aValue.find_first_of(",\"\n\r") == std::string::npos) {
+      aOut << aValue;
+      return;
+    }
+    aOut << '"';
+    for(char c : aValue) {
+      if(c == '"') {
+        aOut << '"';
+      }
+      aOut << c;
+    }
+    aOut << '"';
+  }
+
+  static void writeDouble(ostream& aOut, const double aValue) {
+    if(std::isnan(aValue)) {
+      aOut << "NA";
+    }
+    else if(std::isinf(aValue)) {
+      aOut << (aValue > 0 ? "Inf" : "-Inf");
+    }
+    else {
+      aOut << aValue;
+    }
+  }
+};
+
+#if __HAVE_ARROW__
+/*!
+ * \brief Write query results as an Arrow table in either the Feather (Arrow IPC)
+ *        or Parquet format.
+ * \details Numeric columns are handed to Arrow without copying by wrapping the
+ *          existing buffers, only string columns need to be rebuilt.
+ */
+class ArrowResultWriter : public QueryResultWriter {
+public:
+  ArrowResultWriter(const bool aIsParquet):mIsParquet(aIsParquet)
+  {
+  }
+
+  virtual void addColumn(const std::string& aName, const std::vector<std::string>& aData) {
+    arrow::StringBuilder builder;
+    checkStatus(builder.AppendValues(aData));
+    std::shared_ptr<arrow::Array> array;
+    checkStatus(builder.Finish(&array));
+    addColumn(arrow::field(aName, arrow::utf8()), array);
+  }
+
+  virtual void addColumn(const std::string& aName, const std::vector<int>& aData) {
+    static_assert(sizeof(int) == sizeof(int32_t), "Expecting int to be 32 bits");
+    addColumn(arrow::field(aName, arrow::int32()),
+              std::make_shared<arrow::Int32Array>(aData.size(), arrow::Buffer::Wrap(aData)));
+  }
+
+  virtual void addColumn(const std::string& aName, const std::vector<double>& aData) {
+    addColumn(arrow::field(aName, arrow::float64()),
+              std::make_shared<arrow::DoubleArray>(aData.size(), arrow::Buffer::Wrap(aData)));
+  }
+
+  virtual void write(const std::string& aFileName) {
+    std::shared_ptr<arrow::Table> table = arrow::Table::Make(arrow::schema(mFields), mArrays);
+    arrow::Result<std::shared_ptr<arrow::io::FileOutputStream> > outfile =
+      arrow::io::FileOutputStream::Open(aFileName);
+    checkStatus(outfile.status());
+    if(mIsParquet) {
+      checkStatus(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), *outfile,
+                                             std::max<int64_t>(table->num_rows(), 1)));
+    }
+    else {
+      checkStatus(arrow::ipc::feather::WriteTable(*table, outfile->get()));
+    }
+    checkStatus((*outfile)->Close());
+  }
+
+private:
+  //! If the file should be written as Parquet, otherwise Feather
+  const bool mIsParquet;
+
+  //! The schema of the columns added so far
+  std::vector<std::shared_ptr<arrow::Field> > mFields;
+
+  //! The column data added so far
+  std::vector<std::shared_ptr<arrow::Array> > mArrays;
+
+  void addColumn(const std::shared_ptr<arrow::Field>& aField, const std::shared_ptr<arrow::Array>& aArray) {
+    mFields.push_back(aField);
+    mArrays.push_back(aArray);
+  }
+
+  static void checkStatus(const arrow::Status& aStatus) {
+    if(!aStatus.ok()) {
+      Interp::stop(aStatus.ToString());
+    }
+  }
+};
+#endif
+
+/*!
+ * \brief Create a writer for the given format.
+ * \param aFormat One of "csv", "feather" (or "arrow"), or "parquet".
+ * \return A new writer, an error is raised if the format is unknown or the
+ *         format requires Arrow which is not available.
+ */
+std::unique_ptr<QueryResultWriter> QueryResultWriter::create(const std::string& aFormat) {
+  if(aFormat == "csv") {
+    return std::unique_ptr<QueryResultWriter>(new CSVResultWriter());
+  }
+  else if(aFormat == "feather" || aFormat == "arrow" || aFormat == "parquet") {
+#if __HAVE_ARROW__
+    return std::unique_ptr<QueryResultWriter>(new ArrowResultWriter(aFormat == "parquet"));
+#else
+    Interp::stop("gcamwrapper was not built with Arrow support, "+aFormat+" is not available; use csv instead.");
+#endif
+  }
+  Interp::stop("Unknown export format: "+aFormat);
+  return std::unique_ptr<QueryResultWriter>();
+}
+
+/*!
+ * \brief The conventional file extension, including the dot, for the given format.
+ * \param aFormat The export format as given to create.
+ * \return The file extension.
+ */
+std::string QueryResultWriter::getFileExtension(const std::string& aFormat) {
+  return aFormat == "arrow" ? ".feather" : "."+aFormat;
+}
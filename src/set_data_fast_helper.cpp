@@ -5,6 +5,13 @@
 #include "util/base/include/gcam_fusion.hpp"
 #include "util/base/include/gcam_data_containers.h"
 
+#include "year_range.h"
+
+#include <unordered_set>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
 #include <boost/container_hash/hash.hpp>
 
 using namespace std;
@@ -26,6 +33,9 @@ public:
         return mDataName;
     }
     virtual size_t getHash() const = 0;
+    virtual bool isExactMatch() const {
+        return mToWrap->isExactMatch();
+    }
 
 protected:
     //! The actual AMatchesValue which determines if the current path matches the query
@@ -76,12 +86,96 @@ public:
     int mCurrValue;
 };
 
+/*!
+ * \brief Restricts a predicate to only match values which appear in the
+ *        DataFrame to set.
+ * \details Values are checked against a hash set so that GCAM Fusion skips the
+ *          subtrees of any CONTAINER whose name/year is not in the data at all
+ *          rather than searching them to find nothing to set.  If only a single
+ *          value appears in the data this is an exact match which allows GCAM
+ *          Fusion to stop looking at siblings once it has been found.
+ */
+template<typename T>
+class InDataSetMatcher : public AMatchesValue {
+public:
+    InDataSetMatcher(AMatchesValue* aToWrap, std::unordered_set<T>&& aValues):mToWrap(aToWrap), mValues(std::move(aValues))
+    {
+    }
+    virtual ~InDataSetMatcher() {
+        delete mToWrap;
+    }
+    virtual bool matchesString( const std::string& aStrToTest ) const {
+        return false;
+    }
+    virtual bool matchesInt( const int aIntToTest ) const {
+        return false;
+    }
+    virtual bool isExactMatch() const {
+        return mValues.size() == 1 || mToWrap->isExactMatch();
+    }
+private:
+    //! The predicate given in the query which must also match
+    AMatchesValue* mToWrap;
+    //! All of the values in the data for this column
+    std::unordered_set<T> mValues;
+};
+
+template<>
+bool InDataSetMatcher<std::string>::matchesString( const std::string& aStrToTest ) const {
+    return mValues.find(aStrToTest) != mValues.end() && mToWrap->matchesString(aStrToTest);
+}
+template<>
+bool InDataSetMatcher<int>::matchesInt( const int aIntToTest ) const {
+    return mValues.find(aIntToTest) != mValues.end() && mToWrap->matchesInt(aIntToTest);
+}
+
+/*!
+ * \brief Check if a column name is a year, as used to name the value
+ *        columns in the wide format.
+ * \param aName The column name to check.
+ * \return True if aName is all digits.
+ */
+bool isYearColumn(const std::string& aName) {
+    return !aName.empty() && std::all_of(aName.begin(), aName.end(), [](const char c) { return std::isdigit(c); });
+}
+
 /*!
  * \brief Prepare to run the given query.
+ * \details The data may either be long, with the path columns followed by a
+ *          single value column, or wide, with the path columns followed by a
+ *          value column for each year named by the year.  In the wide format
+ *          there is no year column and the whole vector of data is set for each
+ *          row at once.  Any NaN values in the wide format are left unchanged.
+ * \param aData The DataFrame to read path values, as well as the values to set.
  * \param aQuery The GCAM Fusion query to be parsed
+ * \param aProfile If the work done by each filter step should be recorded,
+ *                 see createProfile.
  */
-SetDataFastHelper::SetDataFastHelper(const Interp::DataFrame& aData, const std::string& aHeader):QueryProcessorBase(), mData(aData) {
-    // parse the query into filter steps
+SetDataFastHelper::SetDataFastHelper(const Interp::DataFrame& aData, const std::string& aHeader, const bool aProfile):QueryProcessorBase(), mData(aData), mIsWide(false) {
+    mProfile = aProfile;
+    std::vector<std::string> colNames = Interp::getDataFrameNames(aData);
+    mNumPathCols = colNames.size() - 1;
+    if(!colNames.empty() && isYearColumn(colNames.back())) {
+        mIsWide = true;
+        while(mNumPathCols > 0 && isYearColumn(colNames[mNumPathCols - 1])) {
+            --mNumPathCols;
+        }
+        std::vector<std::pair<int, int> > yearCols;
+        for(int col = mNumPathCols; col < colNames.size(); ++col) {
+            yearCols.emplace_back(std::stoi(colNames[col]), col);
+        }
+        std::sort(yearCols.begin(), yearCols.end());
+        for(const auto& yearCol : yearCols) {
+            mWideYears.push_back(yearCol.first);
+            mWideValues.push_back(Interp::getDataFrameAt<Interp::NumericVector>(aData, yearCol.second));
+        }
+    }
+
+    // parse the query into filter steps and keep track of the years set so
+    // that callers may know which model periods have been affected, a year
+    // filter on the data itself will be applied in vectorDataHelper
+    mTrackYears = true;
+    mPushDownYearRange = true;
     parseFilterString(aHeader);
 
     // determine if a user already filtered a period vector of data
@@ -93,16 +187,34 @@ SetDataFastHelper::SetDataFastHelper(const Interp::DataFrame& aData, const std::
             hasYearInPath = true;
         }
     }
-    if(mPathTracker.size() < mTempDataID.size() && !hasYearInPath) {
-      mPathTracker.push_back(new IntMatcherHashWrapper(createMatchesAny(), "year"));
+    if((mIsWide || mPathTracker.size() < mTempDataID.size()) && !hasYearInPath) {
+      mPathTracker.push_back(new IntMatcherHashWrapper(trackYear(createMatchesAny()), "year"));
     }
-    if(mPathTracker.size() != mTempDataID.size()) {
+    // in the wide format the year tracker does not read a column
+    if(mPathTracker.size() != mTempDataID.size() + (mIsWide ? 1 : 0)) {
         Interp::stop("Number of column reads did not align with path tracker");
     }
 
-    Interp::NumericVector data(Interp::getDataFrameAt<Interp::NumericVector>(aData, -1));
     int len = getDataFrameNumRows(mData);
+    if(mIsWide) {
+        mWideRows.reserve(len);
+        for(size_t row = 0; row < len; ++row) {
+            std::size_t seed = 0;
+            for(const auto& col : mTempDataID) {
+                boost::hash_combine(seed, col[row]);
+            }
+            mWideRows[seed] = row;
+        }
+        mTempDataID.clear();
+        if(mWideRows.size() != len) {
+            stop("Mismatch in length of hash table, possible collision");
+        }
+        return;
+    }
 
+    Interp::NumericVector data(Interp::getDataFrameAt<Interp::NumericVector>(aData, -1));
+
+    mDataVector.reserve(len);
     for(size_t row = 0; row < len; ++row) {
         std::size_t seed = 0;
         for(const auto& col : mTempDataID) {
@@ -149,39 +261,56 @@ AMatchesValue* SetDataFastHelper::wrapPredicate(AMatchesValue* aToWrap, const st
 }
 
 AMatchesValue* SetDataFastHelper::parsePredicate( const std::vector<std::string>& aFilterOptions, const int aCol, const bool aIsRead ) const {
-    if(aIsRead) {
+    AMatchesValue* matcher = QueryProcessorBase::parsePredicate(aFilterOptions, aCol, aIsRead);
+    if(aIsRead && mIsWide && aCol >= mNumPathCols) {
+        // the years come from the value column names in the wide format
+        if(aFilterOptions[ 0 ] != "YearFilter") {
+            Interp::stop("Wide data is missing a column for the "+aFilterOptions[ 0 ]+" in the query.");
+        }
+    }
+    else if(aIsRead) {
         size_t len = getDataFrameNumRows(mData);
         std::vector<size_t>& retHash = const_cast<SetDataFastHelper*>(this)->mTempDataID.emplace_back(len);
         if( aFilterOptions[ 0 ] == "EnumFilter" ) {
             StringVector enumNames(getDataFrameAt<StringVector>(mData, aCol));
+            std::unordered_set<int> values;
             for(int i = 0; i < len; ++i) {
                 std::string currName = Interp::extract(enumNames[i]);
-                retHash[i] = boost::hash_value<int>(convertToEnum(aFilterOptions[1], currName));
+                int currVal = convertToEnum(aFilterOptions[1], currName);
+                retHash[i] = boost::hash_value<int>(currVal);
+                values.insert(currVal);
             }
+            matcher = new InDataSetMatcher<int>(matcher, std::move(values));
         }
         else if( aFilterOptions[ 0 ] == "NamedFilter" ) {
             StringVector strVals(getDataFrameAt<StringVector>(mData, aCol));
+            std::unordered_set<std::string> values;
             for(int i = 0; i < len; ++i) {
                 std::string currVal = Interp::extract(strVals[i]);
                 retHash[i] = boost::hash_value(currVal);
+                values.insert(currVal);
             }
+            matcher = new InDataSetMatcher<std::string>(matcher, std::move(values));
         }
         else if( aFilterOptions[ 0 ] == "YearFilter" || aFilterOptions[ 0 ] == "IndexFilter" ) {
             IntegerVector strVals(getDataFrameAt<IntegerVector>(mData, aCol));
+            std::unordered_set<int> values;
             for(int i = 0; i < len; ++i) {
                 int currVal(strVals[i]);
                 retHash[i] = boost::hash_value<int>(currVal);
+                values.insert(currVal);
             }
+            matcher = new InDataSetMatcher<int>(matcher, std::move(values));
         }
         else {
             Interp::stop("Unknown filter operand: " + aFilterOptions[ 0 ]);
         }
     }
-    return QueryProcessorBase::parsePredicate(aFilterOptions, aCol, aIsRead);
+    return matcher;
 }
 
 template<typename DataType>
-void processSet(DataType& aDataToSet, const std::map<size_t, double>& aDataVec, const std::vector<AMatcherHashWrapper*>& aPath) {
+bool processSet(DataType& aDataToSet, const std::unordered_map<size_t, double>& aDataVec, const std::vector<AMatcherHashWrapper*>& aPath) {
     size_t seed = 0;
     for(auto tracker : aPath ) {
         boost::hash_combine(seed, tracker->getHash());
@@ -189,24 +318,45 @@ void processSet(DataType& aDataToSet, const std::map<size_t, double>& aDataVec,
     auto it = aDataVec.find(seed);
     if(it != aDataVec.end()) {
         aDataToSet = (*it).second;
+        return true;
     }
+    return false;
 }
 
 
+/*!
+ * \brief Assign a value to an element of a vector of data, or the value of
+ *        a map entry.
+ */
+template<typename DataType>
+void setElement(DataType& aElement, const double aValue) {
+    aElement = aValue;
+}
+template<typename KeyType, typename DataType>
+void setElement(std::pair<KeyType, DataType>& aElement, const double aValue) {
+    aElement.second = aValue;
+}
+
 // GCAM Fusion callbacks with specializations for all of the types that
 // we support:
 
 template<>
 void SetDataFastHelper::processData(double& aData) {
-    processSet(aData, mDataVector, mPathTracker);
+    if(processSet(aData, mDataVector, mPathTracker)) {
+        markDataSet();
+    }
 }
 template<>
 void SetDataFastHelper::processData(Value& aData) {
-    processSet(aData, mDataVector, mPathTracker);
+    if(processSet(aData, mDataVector, mPathTracker)) {
+        markDataSet();
+    }
 }
 template<>
 void SetDataFastHelper::processData(int& aData) {
-    processSet(aData, mDataVector, mPathTracker);
+    if(processSet(aData, mDataVector, mPathTracker)) {
+        markDataSet();
+    }
 }
 template<>
 void SetDataFastHelper::processData(std::vector<int>& aData) {
@@ -250,33 +400,84 @@ void SetDataFastHelper::processData(objects::YearVector<double>& aData) {
 }
 template<>
 void SetDataFastHelper::processData(std::map<unsigned int, double>& aData) {
+  if(mIsWide) {
+      wideVectorDataHelper(aData);
+      return;
+  }
   // the user did not explicitly specify a year filter for this data but
   // it seems better to assume they did rather than implicitly aggregate
   // across model periods
   // so let's add the path tracking filter to record all years the first
   // time we see this for them
-  for(auto iter = aData.begin(); iter != aData.end(); ++iter) {
+  // only visit the years which could match, if the user gave a year filter
+  // it has been pushed down to us to check here
+  AMatchesValue* yearMatcher = mYearRangeMatcher ? mYearRangeMatcher : *mPathTracker.rbegin();
+  forEachInYearRange(aData, mYearRangeStart, mYearRangeEnd, [&](auto aIter, const int aYear) {
     // update the year path tracker which would not have had to match thus far
     // as an ARRAY is not a CONTAINER
-    (*mPathTracker.rbegin())->matchesInt(GetIndexAsYear::convertIterToYear(aData, iter));
-    // delegate to processData to take care of the rest
-    processData((*iter).second);
-  }
+    if(yearMatcher->matchesInt(aYear)) {
+      // delegate to processData to take care of the rest
+      processData((*aIter).second);
+    }
+  });
 }
 template<typename VecType>
 void SetDataFastHelper::vectorDataHelper(VecType& aDataVec) {
+  if(mIsWide) {
+      wideVectorDataHelper(aDataVec);
+      return;
+  }
   // the user did not explicitly specify a year filter for this data but
   // it seems better to assume they did rather than implicitly aggregate
   // across model periods
   // so let's add the path tracking filter to record all years the first
   // time we see this for them
-  for(auto iter = aDataVec.begin(); iter != aDataVec.end(); ++iter) {
+  // only visit the years which could match, if the user gave a year filter
+  // it has been pushed down to us to check here
+  AMatchesValue* yearMatcher = mYearRangeMatcher ? mYearRangeMatcher : *mPathTracker.rbegin();
+  forEachInYearRange(aDataVec, mYearRangeStart, mYearRangeEnd, [&](auto aIter, const int aYear) {
     // update the year path tracker which would not have had to match thus far
     // as an ARRAY is not a CONTAINER
-    (*mPathTracker.rbegin())->matchesInt(GetIndexAsYear::convertIterToYear(aDataVec, iter));
-    // delegate to processData to take care of the rest
-    processData(*iter);
+    if(yearMatcher->matchesInt(aYear)) {
+      // delegate to processData to take care of the rest
+      processData(*aIter);
+    }
+  });
+}
+
+/*!
+ * \brief Set the whole vector of data at once from the matching row of wide data.
+ * \details The path, not including year, is hashed once to find the row and then
+ *          we walk the years of the vector and the value columns together.
+ * \param aDataVec The vector of data to set.
+ */
+template<typename VecType>
+void SetDataFastHelper::wideVectorDataHelper(VecType& aDataVec) {
+  size_t seed = 0;
+  // the year tracker is last and not part of the row hash
+  for(size_t i = 0; i + 1 < mPathTracker.size(); ++i) {
+      boost::hash_combine(seed, mPathTracker[i]->getHash());
   }
+  auto rowIter = mWideRows.find(seed);
+  if(rowIter == mWideRows.end() || mWideYears.empty()) {
+      return;
+  }
+  const size_t row = (*rowIter).second;
+  AMatchesValue* yearMatcher = mYearRangeMatcher ? mYearRangeMatcher : *mPathTracker.rbegin();
+  size_t col = 0;
+  forEachInYearRange(aDataVec, std::max(mYearRangeStart, mWideYears.front()), std::min(mYearRangeEnd, mWideYears.back()),
+                     [&](auto aIter, const int aYear) {
+    while(col < mWideYears.size() && mWideYears[col] < aYear) {
+        ++col;
+    }
+    if(col < mWideYears.size() && mWideYears[col] == aYear && yearMatcher->matchesInt(aYear)) {
+        const double value = mWideValues[col][row];
+        if(!std::isnan(value)) {
+            setElement(*aIter, value);
+            markDataSet();
+        }
+    }
+  });
 }
 
 template<typename T>
@@ -83,13 +83,19 @@ public:
  * \param aData The DataFrame to read name/year values to compare against,
  *              as well as the values to set.
  * \param aQuery The GCAM Fusion query to be parsed
+ * \param aProfile If the work done by each filter step should be recorded,
+ *                 see createProfile.
  */
-SetDataHelper::SetDataHelper(const Interp::DataFrame& aData, const std::string& aHeader):
+SetDataHelper::SetDataHelper(const Interp::DataFrame& aData, const std::string& aHeader, const bool aProfile):
     QueryProcessorBase(),
     mData(aData),
     mDataVector(Interp::getDataFrameAt<Interp::NumericVector>(aData, -1)),
     mRow(0)
 {
+    // keep track of the years set so that callers may know which model periods
+    // have been affected
+    mTrackYears = true;
+    mProfile = aProfile;
     parseFilterString(aHeader);
 }
 
@@ -177,18 +183,22 @@ AMatchesValue* SetDataHelper::parsePredicate( const std::vector<std::string>& aF
 template<>
 void SetDataHelper::processData(double& aData) {
   aData = mDataVector[mRow];
+  markDataSet();
 }
 template<>
 void SetDataHelper::processData(Value& aData) {
   aData = mDataVector[mRow];
+  markDataSet();
 }
 template<>
 void SetDataHelper::processData(int& aData) {
   aData = mDataVector[mRow];
+  markDataSet();
 }
 template<>
 void SetDataHelper::processData(std::pair<unsigned int const, double>& aData) {
   aData.second = mDataVector[mRow];
+  markDataSet();
 }
 template<typename T>
 void SetDataHelper::processData(T& aData) {
@@ -3,6 +3,11 @@
 
 #include <memory>
 #include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#include <Eigen/Dense>
+#include <Eigen/SVD>
 
 #include "containers/include/world.h"
 #include "solution/util/include/solution_info.h"
@@ -15,41 +20,101 @@
 
 using namespace Interp;
 
-SolutionDebugger SolutionDebugger::createInstance(const int aPeriod, const std::string& aMarketFilterStr) {
-  SolutionInfoSet solnInfoSet( scenario->getMarketplace() );
+SolutionDebugger SolutionDebugger::createInstance(const int aPeriod, const std::string& aMarketFilterStr,
+                                                  std::shared_ptr<unsigned long> aModelGeneration)
+{
+  std::shared_ptr<SolutionInfoSet> solnInfoSet(new SolutionInfoSet( scenario->getMarketplace() ));
   SolutionInfoParamParser solnParams;
-  solnInfoSet.init( aPeriod, 0.001, 0.001, &solnParams );
+  solnInfoSet->init( aPeriod, 0.001, 0.001, &solnParams );
 
-  std::unique_ptr<ISolutionInfoFilter> filter(SolutionInfoFilterFactory::createSolutionInfoFilterFromString(aMarketFilterStr));
+  std::shared_ptr<ISolutionInfoFilter> filter(SolutionInfoFilterFactory::createSolutionInfoFilterFromString(aMarketFilterStr));
   if(filter.get()) {
-    solnInfoSet.updateSolvable(filter.get());
+    solnInfoSet->updateSolvable(filter.get());
   }
   else {
     Interp::stop("Could not parse info filter: " + aMarketFilterStr);
   }
 
-  return SolutionDebugger(scenario->getWorld(), scenario->getMarketplace(), solnInfoSet, aPeriod);
+  return SolutionDebugger(scenario->getWorld(), scenario->getMarketplace(), solnInfoSet, filter, aPeriod, aModelGeneration);
 }
 
-SolutionDebugger::SolutionDebugger(World *w, Marketplace *m, SolutionInfoSet &sisin, int per):
+SolutionDebugger::SolutionDebugger(World *w, Marketplace *m, std::shared_ptr<SolutionInfoSet> sisin,
+                                   std::shared_ptr<ISolutionInfoFilter> filter, int per,
+                                   std::shared_ptr<unsigned long> generation):
   world(w),
   marketplace(m),
   solnInfoSet(sisin),
+  solnFilter(filter),
   period(per),
-  nsolv(sisin.getNumSolvable()),
-  F(solnInfoSet,w,m,per,false),
-  x(nsolv),
-  fx(nsolv),
-  marketNames(createVector<std::string, StringVector>(nsolv))
+  nsolv(0),
+  modelGeneration(generation)
 {
-  std::vector<SolutionInfo> smkts(solnInfoSet.getSolvableSet());
+  rebuild();
+}
+
+/*!
+ * \brief Update the debugger to reflect the current state of the model.
+ * \details Allows a debugger to be reused, for instance after the model has
+ *          been re-solved or had data changed, without having to create a new
+ *          one.  The prices, scale factors, and F(x) are updated in place unless
+ *          the markets which pass the market filter have changed in which case
+ *          the debugger is rebuilt as if it were newly created.  Note any scaled
+ *          prices or quantities a user may have already stored may be invalidated.
+ *          The model state must already be set up for the period of this
+ *          debugger, see gcam::refreshSolutionDebugger.
+ * \return If the set of solvable markets changed.
+ */
+bool SolutionDebugger::refresh() {
+  markModelChanged();
+  solnInfoSet->updateFromMarkets();
+  solnInfoSet->updateSolvable(solnFilter.get());
+
+  const std::vector<SolutionInfo>& smkts = solnInfoSet->getSolvableSet();
+  bool changed = smkts.size() != nsolv;
+  for(unsigned int i = 0; !changed && i < nsolv; ++i) {
+    changed = smkts[i].getName().get() != Interp::extract(marketNames[i]);
+  }
+
+  if(changed) {
+    rebuild();
+  }
+  else {
+    for(unsigned int i = 0; i < nsolv; ++i) {
+      x[i] = smkts[i].getPrice();
+    }
+    // the scale factors are only calculated when an LogEDFun is created
+    LogEDFun Fnew(*solnInfoSet, world, marketplace, period, false);
+    F->mfxscl = Fnew.mfxscl;
+    F->mxscl = Fnew.mxscl;
+    F->scaleInitInputs(x);
+    (*F)(x, fx);
+  }
+  return changed;
+}
+
+/*!
+ * \brief (Re)create F, x, and fx for the current set of solvable markets.
+ */
+void SolutionDebugger::rebuild() {
+  markModelChanged();
+  nsolv = solnInfoSet->getNumSolvable();
+  F.reset(new LogEDFun(*solnInfoSet, world, marketplace, period, false));
+  x.resize(nsolv, false);
+  fx.resize(nsolv, false);
+  marketNames = createVector<std::string, StringVector>(nsolv);
+
+  const std::vector<SolutionInfo>& smkts = solnInfoSet->getSolvableSet();
   for(unsigned int i = 0; i < smkts.size(); ++i) {
     x[i] = smkts[i].getPrice();
     marketNames[i] = smkts[i].getName().get().c_str();
   }
 
-  F.scaleInitInputs(x);
-  F(x, fx);
+  F->scaleInitInputs(x);
+  (*F)(x, fx);
+}
+
+int SolutionDebugger::getPeriod() const {
+  return period;
 }
 
 StringVector SolutionDebugger::getMarketNames() {
@@ -61,7 +126,7 @@ NumericVector SolutionDebugger::getPrices(const bool aScaled) {
   for(int i = 0; i < nsolv; ++i) {
       double val = x[i];
       if(!aScaled) {
-          val *= F.mxscl[i];
+          val *= F->mxscl[i];
       }
       ret[i] = val;
   }
@@ -79,9 +144,9 @@ NumericVector SolutionDebugger::getFX() {
 NumericVector SolutionDebugger::getSupply(const bool aScaled) {
   NumericVector ret(createVector<double, NumericVector>(nsolv));
   for(int i = 0; i < nsolv; ++i) {
-      double val = solnInfoSet.getSolvable(i).getSupply();
+      double val = solnInfoSet->getSolvable(i).getSupply();
       if(aScaled) {
-          val /= 1.0/F.mfxscl[i];
+          val /= 1.0/F->mfxscl[i];
       }
     ret[i] = val;
   }
@@ -92,9 +157,9 @@ NumericVector SolutionDebugger::getSupply(const bool aScaled) {
 NumericVector SolutionDebugger::getDemand(const bool aScaled) {
   NumericVector ret(createVector<double, NumericVector>(nsolv));
   for(int i = 0; i < nsolv; ++i) {
-      double val = solnInfoSet.getSolvable(i).getDemand();
+      double val = solnInfoSet->getSolvable(i).getDemand();
       if(aScaled) {
-          val /= 1.0/F.mfxscl[i];
+          val /= 1.0/F->mfxscl[i];
       }
     ret[i] = val;
   }
@@ -105,7 +170,7 @@ NumericVector SolutionDebugger::getDemand(const bool aScaled) {
 NumericVector SolutionDebugger::getPriceScaleFactor() {
   NumericVector ret(createVector<double, NumericVector>(nsolv));
   for(int i = 0; i < nsolv; ++i) {
-    ret[i] = F.mxscl[i];
+    ret[i] = F->mxscl[i];
   }
   setVectorNames(ret, marketNames);
   return ret;
@@ -114,7 +179,7 @@ NumericVector SolutionDebugger::getPriceScaleFactor() {
 NumericVector SolutionDebugger::getQuantityScaleFactor() {
   NumericVector ret(createVector<double, NumericVector>(nsolv));
   for(int i = 0; i < nsolv; ++i) {
-    ret[i] = 1.0/F.mfxscl[i];
+    ret[i] = 1.0/F->mfxscl[i];
   }
   setVectorNames(ret, marketNames);
   return ret;
@@ -125,7 +190,7 @@ void SolutionDebugger::setPrices(const NumericVector& aPrices, const bool aScale
     x[i] = aPrices[i];
   }
   if(!aScaled) {
-    F.scaleInitInputs(x);
+    F->scaleInitInputs(x);
   }
 }
 
@@ -145,7 +210,8 @@ NumericVector SolutionDebugger::evaluate(const NumericVector& aPrices, const boo
            scenario->getManageStateVariables()->mStateData[0],
            (sizeof( double)) * scenario->getManageStateVariables()->mNumCollected);
   }
-  F(x,fx);
+  markModelChanged();
+  (*F)(x,fx);
   NumericVector fx_ret = getFX();
   if(aResetAfterCalc) {
     memcpy(scenario->getManageStateVariables()->mStateData[0], resetState.get(),
@@ -159,12 +225,13 @@ NumericVector SolutionDebugger::evaluate(const NumericVector& aPrices, const boo
 
 NumericVector SolutionDebugger::evaluatePartial(const double aPrice, const int aIndex, const bool aScaled) {
   double x_restore = x[aIndex];
-  x[aIndex] = aScaled ? aPrice : aPrice / F.mxscl[aIndex];
+  x[aIndex] = aScaled ? aPrice : aPrice / F->mxscl[aIndex];
   scenario->getManageStateVariables()->setPartialDeriv(true);
-  F.partial(aIndex);
+  F->partial(aIndex);
   UBVECTOR fx_restore = fx;
-  F(x,fx,aIndex);
-  F.partial(-1);
+  markModelChanged();
+  (*F)(x,fx,aIndex);
+  F->partial(-1);
   x[aIndex] = x_restore;
   NumericVector fx_ret = getFX();
   fx = fx_restore;
@@ -178,17 +245,178 @@ NumericMatrix SolutionDebugger::calcDerivative() {
     indicies.push_back(i);
   }
   UBMATRIX jac(nsolv,nsolv);
-  fdjac(F, x, fx, jac, indicies, true);
+  markModelChanged();
+  fdjac(*F, x, fx, jac, indicies, true);
   NumericMatrix jacRet = wrapMatrix(jac, nsolv);
   Interp::setMatrixNames(jacRet, marketNames);
 
   return jacRet;
 }
 
+/*!
+ * \brief Calculate the Newton step and conditioning of the Jacobian at the
+ *        current prices.
+ * \details The Jacobian is calculated as in calcDerivative but is factored here
+ *          rather than being returned so only compact diagnostics need to be
+ *          passed back.  A partial pivoting LU gives the Newton step and an
+ *          estimate of the reciprocal condition number.  If requested, an SVD is
+ *          used to find the markets which contribute the most to the directions
+ *          in which the Jacobian is closest to singular, i.e. the right singular
+ *          vectors of the smallest singular values.
+ * \param aNumGroups The number of smallest singular values to report markets
+ *                   for, zero skips the SVD.
+ * \param aNumMarkets The number of markets to report for each singular value.
+ * \return A List of the Newton step in scaled prices, the reciprocal condition
+ *         number estimate, and a DataFrame of the ill-conditioned market groups.
+ */
+List SolutionDebugger::calcNewtonDiagnostics(const int aNumGroups, const int aNumMarkets) {
+  std::list<int> indicies;
+  for(int i = 0; i < nsolv; ++i) {
+    indicies.push_back(i);
+  }
+  UBMATRIX jac(nsolv,nsolv);
+  markModelChanged();
+  fdjac(*F, x, fx, jac, indicies, true);
+
+  Eigen::MatrixXd jacE(nsolv, nsolv);
+  Eigen::VectorXd fxE(nsolv);
+  for(int i = 0; i < nsolv; ++i) {
+    for(int j = 0; j < nsolv; ++j) {
+      jacE(i, j) = jac(i, j);
+    }
+    fxE[i] = fx[i];
+  }
+
+  Eigen::PartialPivLU<Eigen::MatrixXd> lu(jacE);
+  Eigen::VectorXd dx = lu.solve(-fxE);
+  NumericVector step(createVector<double, NumericVector>(nsolv));
+  for(int i = 0; i < nsolv; ++i) {
+    step[i] = dx[i];
+  }
+  setVectorNames(step, marketNames);
+
+  std::vector<int> group;
+  std::vector<double> singularValue;
+  std::vector<std::string> market;
+  std::vector<double> weight;
+  const int numGroups = std::min(std::max(aNumGroups, 0), static_cast<int>(nsolv));
+  const int numMarkets = std::min(std::max(aNumMarkets, 0), static_cast<int>(nsolv));
+  if(numGroups > 0 && numMarkets > 0) {
+    Eigen::BDCSVD<Eigen::MatrixXd> svd(jacE, Eigen::ComputeFullV);
+    std::vector<int> order(nsolv);
+    for(int g = 0; g < numGroups; ++g) {
+      // singular values are sorted in decreasing order
+      const int col = nsolv - 1 - g;
+      auto v = svd.matrixV().col(col);
+      std::iota(order.begin(), order.end(), 0);
+      std::partial_sort(order.begin(), order.begin() + numMarkets, order.end(), [&v](const int aLHS, const int aRHS) {
+        return std::abs(v[aLHS]) > std::abs(v[aRHS]);
+      });
+      for(int m = 0; m < numMarkets; ++m) {
+        group.push_back(g + 1);
+        singularValue.push_back(svd.singularValues()[col]);
+        market.push_back(Interp::extract(marketNames[order[m]]));
+        weight.push_back(v[order[m]]);
+      }
+    }
+  }
+  DataFrame illConditioned = Interp::createDataFrame();
+  illConditioned["group"] = Interp::wrap(group);
+  illConditioned["singular_value"] = Interp::wrap(singularValue);
+  illConditioned["market"] = Interp::wrap(market);
+  illConditioned["weight"] = Interp::wrap(weight);
+
+  List ret = Interp::createList(3);
+  Interp::setListAt(ret, 0, step);
+  Interp::setListAt(ret, 1, lu.rcond());
+  Interp::setListAt(ret, 2, illConditioned);
+  return ret;
+}
+
+/*!
+ * \brief Solve just the markets in this debugger holding all other prices fixed.
+ * \details A Newton's method with a backtracking line search on ||F(x)||^2 is used
+ *          starting from the current prices.  The Jacobian is recalculated each
+ *          iteration as the number of markets is expected to be small.  The solve
+ *          stops if the line search fails to find an acceptable step and the model
+ *          is left at the last accepted prices even if the solve failed.
+ * \param aMaxIter The maximum number of Newton iterations.
+ * \param aTolerance The largest absolute scaled F(x) which is considered solved.
+ * \return If all markets were solved to within aTolerance.
+ */
+bool SolutionDebugger::solve(const int aMaxIter, const double aTolerance) {
+  // the maximum number of times to halve the step in the line search
+  const int MAX_BACKTRACK = 10;
+  // the fraction of the expected decrease a step must achieve to be accepted
+  const double ARMIJO_C = 1e-4;
+  auto maxAbs = [](const UBVECTOR& aVec) {
+    double ret = 0.0;
+    for(double val : aVec) {
+      ret = std::max(ret, std::abs(val));
+    }
+    return ret;
+  };
+
+  std::list<int> indicies;
+  for(int i = 0; i < nsolv; ++i) {
+    indicies.push_back(i);
+  }
+  UBMATRIX jac(nsolv,nsolv);
+  Eigen::MatrixXd jacE(nsolv, nsolv);
+  Eigen::VectorXd fxE(nsolv);
+  UBVECTOR xNew(nsolv);
+  UBVECTOR fxNew(nsolv);
+
+  markModelChanged();
+  (*F)(x, fx);
+  bool isStateCurrent = true;
+  for(int iter = 0; iter < aMaxIter && maxAbs(fx) >= aTolerance; ++iter) {
+    fdjac(*F, x, fx, jac, indicies, true);
+    isStateCurrent = false;
+    for(int i = 0; i < nsolv; ++i) {
+      for(int j = 0; j < nsolv; ++j) {
+        jacE(i, j) = jac(i, j);
+      }
+      fxE[i] = fx[i];
+    }
+    Eigen::VectorXd dx = Eigen::PartialPivLU<Eigen::MatrixXd>(jacE).solve(-fxE);
+    if(!dx.allFinite()) {
+      // singular Jacobian, we can not make any more progress
+      break;
+    }
+
+    const double f0 = 0.5 * inner_prod(fx, fx);
+    double lambda = 1.0;
+    bool accepted = false;
+    for(int backtrack = 0; backtrack <= MAX_BACKTRACK && !accepted; ++backtrack, lambda *= 0.5) {
+      for(int i = 0; i < nsolv; ++i) {
+        xNew[i] = x[i] + lambda * dx[i];
+      }
+      (*F)(xNew, fxNew);
+      // for a Newton step the directional derivative of f0 is -2 * f0
+      accepted = 0.5 * inner_prod(fxNew, fxNew) <= (1.0 - 2.0 * ARMIJO_C * lambda) * f0;
+    }
+    if(!accepted) {
+      // the line search failed, stay at the last accepted prices rather than
+      // risk moving somewhere we can not come back from
+      break;
+    }
+    x = xNew;
+    fx = fxNew;
+    isStateCurrent = true;
+  }
+  if(!isStateCurrent) {
+    // make sure the model is left consistent with x
+    (*F)(x, fx);
+  }
+
+  return maxAbs(fx) < aTolerance;
+}
+
 NumericVector SolutionDebugger::getSlope() {
   NumericVector slope(createVector<double, NumericVector>(nsolv));
   for(int i = 0; i < nsolv; ++i) {
-    slope[i] = solnInfoSet.getSolvable(i).getCorrectionSlope(F.mxscl[i], 1.0/F.mfxscl[i]);
+    slope[i] = solnInfoSet->getSolvable(i).getCorrectionSlope(F->mxscl[i], 1.0/F->mfxscl[i]);
   }
   setVectorNames(slope, marketNames);
   return slope;
@@ -199,23 +427,30 @@ void SolutionDebugger::setSlope(const NumericVector& aDX) {
   for(int i = 0; i < nsolv; ++i) {
     dx[i] = aDX[i];
   }
-  F.setSlope(dx);
+  markModelChanged();
+  F->setSlope(dx);
 }
 
 void SolutionDebugger::resetScales(const NumericVector& aPriceScale,
                                    const NumericVector& aQuantityScale)
 {
   // changing scales will invalidate F, x, and fx so we will have to recreate these
-  std::vector<SolutionInfo> smkts(solnInfoSet.getSolvableSet());
-  for(int i = 0; i < nsolv; ++i) {
-    x[i] = smkts[i].getPrice();
-    smkts[i].setForecastPrice(aPriceScale[i]);
-    smkts[i].setForecastDemand(aQuantityScale[i]);
+  for(unsigned int i = 0; i < nsolv; ++i) {
+    SolutionInfo& currInfo = solnInfoSet->getSolvable(i);
+    x[i] = currInfo.getPrice();
+    currInfo.setForecastPrice(aPriceScale[i]);
+    currInfo.setForecastDemand(aQuantityScale[i]);
   }
-  LogEDFun Fnew(solnInfoSet, world, marketplace, period, false);
-  F.mfxscl = Fnew.mfxscl;
-  F.mxscl = Fnew.mxscl;
-  F.scaleInitInputs(x);
-  F(x, fx);
+  LogEDFun Fnew(*solnInfoSet, world, marketplace, period, false);
+  F->mfxscl = Fnew.mfxscl;
+  F->mxscl = Fnew.mxscl;
+  F->scaleInitInputs(x);
+  markModelChanged();
+  (*F)(x, fx);
 }
 
+void SolutionDebugger::markModelChanged() {
+  if(modelGeneration) {
+    ++(*modelGeneration);
+  }
+}
@@ -0,0 +1,110 @@
+#include "interp_interface.h"
+
+#include "solver_trace.h"
+
+#include <cmath>
+#include <vector>
+
+#include "containers/include/scenario.h"
+#include "solution/util/include/solution_info.h"
+#include "solution/util/include/solution_info_set.h"
+#include "solution/util/include/solution_info_param_parser.h"
+
+using namespace std;
+using namespace Interp;
+
+extern Scenario* scenario;
+
+SolverTrace::SolverTrace(const size_t aCapacity):mEntries(aCapacity), mNumAttempts(0)
+{
+}
+
+/*!
+ * \brief Record a solver attempt for the given period.
+ * \details The worst market is found by checking the relative excess demand of
+ *          all markets which are solvable in aPeriod as they were left by the
+ *          solver.
+ * \param aPeriod The model period which was solved.
+ * \param aMethod A label for the wrapper call which triggered the solve.
+ * \param aSuccess If the solver reported success.
+ * \param aElapsed The wall clock time in seconds to run the period, from
+ *                 initializing it through the climate model and feedbacks,
+ *                 or just the time to solve for solve_markets.
+ * \param aNumCalcs The number of model calculations over the same scope as
+ *                  aElapsed, which measures how hard the solver had to work.
+ */
+void SolverTrace::record(const int aPeriod, const std::string& aMethod, const bool aSuccess, const double aElapsed,
+                         const double aNumCalcs)
+{
+  SolutionInfoSet solnInfoSet( scenario->getMarketplace() );
+  SolutionInfoParamParser solnParams;
+  solnInfoSet.init( aPeriod, 0.001, 0.001, &solnParams );
+
+  Entry entry;
+  entry.mAttempt = ++mNumAttempts;
+  entry.mPeriod = aPeriod;
+  entry.mMethod = aMethod;
+  entry.mSuccess = aSuccess;
+  entry.mMaxRelED = 0.0;
+  entry.mElapsed = aElapsed;
+  entry.mNumCalcs = aNumCalcs;
+  for(unsigned int i = 0; i < solnInfoSet.getNumSolvable(); ++i) {
+    const SolutionInfo& info = solnInfoSet.getSolvable(i);
+    double relED = std::abs(info.getRelativeED());
+    if(relED > entry.mMaxRelED || (entry.mWorstMarket.empty() && !std::isfinite(relED))) {
+      entry.mMaxRelED = relED;
+      entry.mWorstMarket = info.getName().get();
+    }
+  }
+  mEntries.push_back(entry);
+}
+
+/*!
+ * \brief Change the maximum number of entries to keep.
+ * \details If the new capacity is smaller than the current number of entries the
+ *          oldest entries are dropped.
+ * \param aCapacity The new maximum number of entries.
+ */
+void SolverTrace::setCapacity(const size_t aCapacity) {
+  mEntries.set_capacity(aCapacity);
+}
+
+void SolverTrace::clear() {
+  mEntries.clear();
+}
+
+/*!
+ * \brief Organize the recorded entries into a DataFrame, oldest first.
+ * \return A DataFrame with one row per solver attempt.
+ */
+DataFrame SolverTrace::getDataFrame() const {
+  vector<int> attempt;
+  vector<int> period;
+  vector<string> method;
+  vector<int> success;
+  vector<double> maxRelED;
+  vector<string> worstMarket;
+  vector<double> elapsed;
+  vector<double> numCalcs;
+  for(const auto& entry : mEntries) {
+    attempt.push_back(entry.mAttempt);
+    period.push_back(entry.mPeriod);
+    method.push_back(entry.mMethod);
+    success.push_back(entry.mSuccess);
+    maxRelED.push_back(entry.mMaxRelED);
+    worstMarket.push_back(entry.mWorstMarket);
+    elapsed.push_back(entry.mElapsed);
+    numCalcs.push_back(entry.mNumCalcs);
+  }
+
+  DataFrame ret = Interp::createDataFrame();
+  ret["attempt"] = Interp::wrap(attempt);
+  ret["period"] = Interp::wrap(period);
+  ret["method"] = Interp::wrap(method);
+  ret["success"] = Interp::wrap(success);
+  ret["max_relative_ed"] = Interp::wrap(maxRelED);
+  ret["worst_market"] = Interp::wrap(worstMarket);
+  ret["elapsed"] = Interp::wrap(elapsed);
+  ret["model_calcs"] = Interp::wrap(numCalcs);
+  return ret;
+}